@@ -40,18 +40,24 @@ Sample Benchmark::run (Buffer const& input, int repeat_cnt, Lz const& encoder) {
     std::vector<milliseconds> lz_decoding_ms;
     std::vector<milliseconds> huffman_encoding_ms;
     std::vector<milliseconds> huffman_decoding_ms;
+    // The buffers are reused across repetitions, so only the first one pays
+    // for their allocation.
+    Buffer lz_output;
+    Buffer huffman_output;
+    Buffer huffman_input;
+    Buffer lz_input;
     while (repeat_cnt --> 0) {
         auto t0 = system_clock::now();
-        Buffer lz_output = encoder.encode(input);
+        encoder.encode(input, lz_output);
         sample.codewords = lz_output.size() / encoder.codeword_bits();
         sample.lz_bits = lz_output.size();
         auto t1 = system_clock::now();
-        Buffer huffman_output = Huffman::encode(lz_output);
+        Huffman::encode(lz_output, huffman_output);
         sample.huffman_bits = huffman_output.size();
         auto t2 = system_clock::now();
-        Buffer huffman_input = Huffman::decode(huffman_output);
+        Huffman::decode(huffman_output, huffman_input);
         auto t3 = system_clock::now();
-        Buffer lz_input = encoder.decode(huffman_input);
+        encoder.decode(huffman_input, lz_input);
         auto t4 = system_clock::now();
         if (!(lz_input == input)) {
             throw "Something went wrong!";
@@ -10,12 +10,12 @@
 #include "input_provider.h"
 
 struct Sample {
-    int input_bits;
-    int codewords;
-    int lz_bits;
+    int64_t input_bits;
+    int64_t codewords;
+    int64_t lz_bits;
     int lz_encoding_ms;
     int lz_decoding_ms;
-    int huffman_bits;
+    int64_t huffman_bits;
     int huffman_encoding_ms;
     int huffman_decoding_ms;
 };
@@ -0,0 +1,70 @@
+#include "prefix.h"
+#include <fstream>
+
+#include "../src/block_codec.h"
+#include "../src/buffer.h"
+#include "../src/huffman.h"
+#include "../src/lzw.h"
+#include "../src/smru_dict.h"
+
+void blocks_sample (
+    Buffer const& input,
+    Lz const& lz,
+    int64_t block_char_cnt,
+    int thread_cnt,
+    int64_t whole_bits
+) {
+    ThreadPool pool(thread_cnt - 1);
+    BlockCodec codec(lz, block_char_cnt, pool);
+    Buffer output;
+    Buffer decoded;
+
+    auto t0 = system_clock::now();
+    codec.encode(input, output);
+    auto t1 = system_clock::now();
+    codec.decode(output, decoded);
+    auto t2 = system_clock::now();
+    assert(decoded == input);
+
+    double const char_cnt = input.size() / CHAR_BITS;
+    double const encode_ns = duration_cast<nanoseconds>(t1 - t0).count();
+    double const decode_ns = duration_cast<nanoseconds>(t2 - t1).count();
+    double const ratio = double(output.size()) / input.size();
+    cout << block_char_cnt
+         << " " << thread_cnt
+         << " " << char_cnt / encode_ns * 1000.0
+         << " " << char_cnt / decode_ns * 1000.0
+         << " " << ratio
+         << " " << double(output.size()) / whole_bits - 1.0
+         << endl;
+}
+
+void blocks (string const& filename) {
+    cout << "# Block-parallel coding with LZW + SMRU and Huffman\n"
+         << "# ==============================================================\n"
+         << "# block_chars threads encode_mb_per_s decode_mb_per_s ratio "
+            "ratio_cost" << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    cout << "# Huffman header: at least "
+         << Huffman::encode(Buffer()).size() << " bits per block" << endl;
+
+    Lzw<Smru> lz(4096);
+    // A single block is the baseline the ratio cost is relative to.
+    ThreadPool serial(0);
+    int64_t const whole_bits =
+        BlockCodec(lz, char_cnt, serial).encode(input).size();
+
+    int const max_thread_cnt = ThreadPool::default_worker_cnt() + 1;
+    for (int64_t block_char_cnt = 1 << 14; ; block_char_cnt *= 4) {
+        block_char_cnt = min(block_char_cnt, char_cnt);
+        for (int thread_cnt = 1; thread_cnt <= max_thread_cnt; thread_cnt *= 2)
+            blocks_sample(input, lz, block_char_cnt, thread_cnt, whole_bits);
+        if (block_char_cnt == char_cnt)
+            break;
+    }
+}
@@ -0,0 +1,68 @@
+#include "prefix.h"
+#include <fstream>
+#include <vector>
+
+#include "../src/buffer.h"
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+#include "../src/smru_dict.h"
+
+// Number of times every decoding is repeated, the fastest one is reported.
+static int const DECODE_REPEAT_CNT = 5;
+
+void decode_sample (
+    Buffer const& input,
+    Lz const& lz,
+    string const& name,
+    int limit
+) {
+    Buffer output;
+    lz.encode(input, output);
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+
+    Buffer decoded;
+    double buffer_ns = 0.0;
+    for (int i = 0; i < DECODE_REPEAT_CNT; ++i) {
+        auto t0 = system_clock::now();
+        lz.decode(output, decoded);
+        auto t1 = system_clock::now();
+        double const ns = duration_cast<nanoseconds>(t1 - t0).count();
+        buffer_ns = i == 0 ? ns : min(buffer_ns, ns);
+    }
+    assert(decoded == input);
+
+    std::vector<char> array(char_cnt);
+    double array_ns = 0.0;
+    for (int i = 0; i < DECODE_REPEAT_CNT; ++i) {
+        auto t0 = system_clock::now();
+        lz.decode(output, array.data(), char_cnt);
+        auto t1 = system_clock::now();
+        double const ns = duration_cast<nanoseconds>(t1 - t0).count();
+        array_ns = i == 0 ? ns : min(array_ns, ns);
+    }
+    assert(string(array.begin(), array.end()) ==
+        BufferCharSlice(input, 0, char_cnt));
+
+    cout << name
+         << " " << limit
+         << " " << char_cnt / buffer_ns * 1000.0
+         << " " << char_cnt / array_ns * 1000.0
+         << endl;
+}
+
+void decode (string const& filename) {
+    cout << "# Decoding throughput\n"
+         << "# ==============================================================\n"
+         << "# scheme limit buffer_mb_per_s array_mb_per_s"
+         << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+
+    for (int limit = 1 << 8; limit <= 1 << 16; limit *= 4) {
+        decode_sample(input, Lz78<Smru>(limit), "lz78", limit);
+        decode_sample(input, Lzw<Smru>(limit), "lzw", limit);
+    }
+}
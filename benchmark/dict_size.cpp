@@ -18,9 +18,7 @@ void dict_size (string const& filename) {
     std::ifstream odyssey(filename.c_str());
     Buffer input;
     BufferCharWriter writer(input);
-    char a;
-    while (odyssey.get(a))
-        writer.put(a);
+    writer.put_stream(odyssey);
     odyssey.close();
 
     int ds[] = {
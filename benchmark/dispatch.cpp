@@ -0,0 +1,81 @@
+#include "prefix.h"
+#include <fstream>
+
+#include "../src/buffer.h"
+#include "../src/mra_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+// Runs the LZ78 factorization loop over the input attached to `dict` and
+// returns the number of codewords. Instantiated with a concrete dictionary, the
+// calls are resolved statically and `try_char()` can be inlined. Instantiated
+// with `EncodeDict` they go through the vtable.
+template <typename Dict>
+int64_t factorize (Dict& dict) {
+    int64_t codeword_cnt = 0;
+    int64_t ahead = 0;
+    while (!dict.eob()) {
+        while (!dict.eob()) {
+            Match match = dict.try_char();
+            ++ahead;
+            if (match.is_maximal()) {
+                ++codeword_cnt;
+                dict.put_back(ahead - match.length - 1);
+                ahead = 0;
+            }
+        }
+        if (ahead != 0) {
+            Match match = dict.fail_char();
+            ++codeword_cnt;
+            if (match.length != ahead) {
+                dict.put_back(ahead - match.length - 1);
+                ahead = 0;
+            }
+        }
+    }
+    return codeword_cnt;
+}
+
+// Hides the dynamic type of `*dict` from the compiler.
+EncodeDict& opaque (EncodeDict* dict) {
+    EncodeDict* volatile result = dict;
+    return *result;
+}
+
+template <typename EncodeDictType>
+void dispatch_sample (string const& name, Buffer const& input, int limit) {
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+
+    auto t0 = system_clock::now();
+    EncodeDictType static_dict(input, limit, false);
+    int64_t static_cnt = factorize(static_dict);
+    auto t1 = system_clock::now();
+    EncodeDictType virtual_dict(input, limit, false);
+    int64_t virtual_cnt = factorize(opaque(&virtual_dict));
+    auto t2 = system_clock::now();
+    assert(static_cnt == virtual_cnt);
+
+    double static_ns = duration_cast<nanoseconds>(t1 - t0).count();
+    double virtual_ns = duration_cast<nanoseconds>(t2 - t1).count();
+    cout << name
+         << " " << static_ns / char_cnt
+         << " " << virtual_ns / char_cnt
+         << " # " << static_cnt << " " << virtual_cnt << endl;
+}
+
+void dispatch (string const& filename) {
+    cout << "# Static vs virtual dispatch of the encode dictionaries\n"
+         << "# ==============================================================\n"
+         << "# dict static_ns_per_char virtual_ns_per_char" << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+
+    int const limit = 25000;
+    dispatch_sample<Smru::EncodeDict>("smru", input, limit);
+    dispatch_sample<Smru2::EncodeDict>("smru2", input, limit);
+    dispatch_sample<Wmru::EncodeDict>("wmru", input, limit);
+    dispatch_sample<Mra::EncodeDict>("mra", input, limit);
+}
@@ -0,0 +1,50 @@
+#include "prefix.h"
+#include <fstream>
+
+#include "../src/hash_dict.h"
+#include "../src/lzw.h"
+#include "../src/mra_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+// Number of times every encoding is repeated, the fastest one is reported.
+static int const ENCODE_REPEAT_CNT = 3;
+
+// Returns the encoding throughput of `lz` in MB/s.
+double hash_dict_sample (Buffer const& input, Lz const& lz) {
+    Buffer output;
+    double best_ns = 0.0;
+    for (int i = 0; i < ENCODE_REPEAT_CNT; ++i) {
+        auto t0 = system_clock::now();
+        lz.encode(input, output);
+        auto t1 = system_clock::now();
+        double const ns = duration_cast<nanoseconds>(t1 - t0).count();
+        best_ns = i == 0 ? ns : min(best_ns, ns);
+    }
+    return input.size() / CHAR_BITS / best_ns * 1000.0;
+}
+
+void hash_dict (string const& filename) {
+    cout << "# LZW encoding throughput, trie vs hash table dictionaries\n"
+         << "# ==============================================================\n"
+         << "# limit smru smru2 hash_smru flat_smru wmru hash_wmru mra hash_mra"
+         << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+
+    for (int limit = 1 << 8; limit <= 1 << 16; limit *= 4) {
+        cout << limit
+             << " " << hash_dict_sample(input, Lzw<Smru>(limit))
+             << " " << hash_dict_sample(input, Lzw<Smru2>(limit))
+             << " " << hash_dict_sample(input, Lzw<HashSmru>(limit))
+             << " " << hash_dict_sample(input, Lzw<FlatSmru>(limit))
+             << " " << hash_dict_sample(input, Lzw<Wmru>(limit))
+             << " " << hash_dict_sample(input, Lzw<HashWmru>(limit))
+             << " " << hash_dict_sample(input, Lzw<Mra>(limit))
+             << " " << hash_dict_sample(input, Lzw<HashMra>(limit))
+             << endl;
+    }
+}
@@ -14,9 +14,10 @@ int AlphabetInputProvider::max_get_cnt () const {
 }
 
 Buffer const& AlphabetInputProvider::get () {
-    for (int i = 0; i < 5; ++i) {
-        for (int a = 0; a < CHAR_CNT; ++a)
-            m_writer.put(a);
-    }
+    char alphabet[CHAR_CNT];
+    for (int a = 0; a < CHAR_CNT; ++a)
+        alphabet[a] = a;
+    for (int i = 0; i < 5; ++i)
+        m_writer.put(alphabet, CHAR_CNT);
     return m_input;
 }
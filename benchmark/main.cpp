@@ -3,10 +3,57 @@
 extern void dict_size (string const& filename);
 extern void time (string const& filename);
 extern void incremental (string const& filename);
+extern void word_size (string const& filename);
+extern void dispatch (string const& filename);
+extern void blocks (string const& filename);
+extern void preset (string const& filename);
+extern void decode (string const& filename);
+extern void hash_dict (string const& filename);
+extern void word_tree_node ();
+extern void pool ();
+extern void pool_dict_tree (string const& filename);
+extern void single_pass (
+    string const& text_filename,
+    string const& binary_filename
+);
 
 int main (int argc, char** argv) {
-    //dict_size("../benchmark/data/duck.bmp");
-    //time("../benchmark/data/odyssey.txt");
-    incremental("../benchmark/data/aaa.txt");
+    // Benchmarks can be selected by name, optionally followed by the input
+    // file. With no arguments, the default one is run.
+    string name = argc > 1 ? argv[1] : "incremental";
+    if (name == "dict_size") {
+        dict_size(argc > 2 ? argv[2] : "../benchmark/data/duck.bmp");
+    } else if (name == "time") {
+        time(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "incremental") {
+        incremental(argc > 2 ? argv[2] : "../benchmark/data/aaa.txt");
+    } else if (name == "word_size") {
+        word_size(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "dispatch") {
+        dispatch(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "blocks") {
+        blocks(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "preset") {
+        preset(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "decode") {
+        decode(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "hash_dict") {
+        hash_dict(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "word_tree_node") {
+        word_tree_node();
+    } else if (name == "pool") {
+        pool();
+    } else if (name == "pool_dict_tree") {
+        pool_dict_tree(argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt");
+    } else if (name == "single_pass") {
+        single_pass(
+            argc > 2 ? argv[2] : "../benchmark/data/odyssey.txt",
+            // Any executable makes for a binary input, this one included.
+            argc > 3 ? argv[3] : "/proc/self/exe"
+        );
+    } else {
+        cout << "Unknown benchmark '" << name << "'" << endl;
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,52 @@
+#include "prefix.h"
+#include <vector>
+
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+// Number of `match()` calls timed.
+static int const MATCH_CNT = 1 << 22;
+
+// Number of times every run is repeated, the fastest one is reported.
+static int const POOL_REPEAT_CNT = 3;
+
+// Returns the time of a single `match()` in nanoseconds.
+template <typename Pool>
+double pool_sample (int limit, std::vector<int> const& trace) {
+    double best_ns = 0.0;
+    int64_t sum = 0;
+    for (int k = 0; k < POOL_REPEAT_CNT; ++k) {
+        Pool pool(limit, false);
+        auto t0 = system_clock::now();
+        for (int i : trace)
+            sum += pool.match(i);
+        auto t1 = system_clock::now();
+        double const ns = duration_cast<nanoseconds>(t1 - t0).count();
+        best_ns = k == 0 ? ns : min(best_ns, ns);
+    }
+    // The sum keeps the matches from being optimized away.
+    if (sum == 0)
+        cout << "# No codewords matched" << endl;
+    return best_ns / trace.size();
+}
+
+void pool () {
+    cout << "# Codeword pool match() time\n"
+         << "# ==============================================================\n"
+         << "# limit smru_ns_per_match wmru_ns_per_match" << endl;
+    assert(false);
+    for (int limit : {1 << 10, 1 << 16, 1 << 20}) {
+        // Uniformly random codewords out of those handed out so far. Both
+        // pools hand out a fresh one on every match until they are full.
+        uint32_t state = 1;
+        std::vector<int> trace;
+        for (int k = 0; k < MATCH_CNT; ++k) {
+            state = state * 1103515245 + 12345;
+            trace.push_back((state >> 4) % (min(k, limit) + 1));
+        }
+        cout << limit
+             << " " << pool_sample<SmruPool>(limit, trace)
+             << " " << pool_sample<WmruPool>(limit, trace)
+             << endl;
+    }
+}
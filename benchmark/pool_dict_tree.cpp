@@ -0,0 +1,64 @@
+#include "prefix.h"
+#include <fstream>
+#include <vector>
+
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+#include "../src/mra_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+// Number of times every run is repeated, the fastest one is reported.
+static int const TREE_REPEAT_CNT = 3;
+
+// Returns the throughput in MB/s of `lz` encoding `chunks` one by one, each
+// with a dictionary of its own.
+double pool_dict_tree_sample (
+    std::vector<Buffer> const& chunks,
+    Lz const& lz
+) {
+    Buffer output;
+    int64_t char_cnt = 0;
+    for (Buffer const& chunk : chunks)
+        char_cnt += chunk.size() / CHAR_BITS;
+    double best_ns = 0.0;
+    for (int i = 0; i < TREE_REPEAT_CNT; ++i) {
+        auto t0 = system_clock::now();
+        for (Buffer const& chunk : chunks)
+            lz.encode(chunk, output);
+        auto t1 = system_clock::now();
+        double const ns = duration_cast<nanoseconds>(t1 - t0).count();
+        best_ns = i == 0 ? ns : min(best_ns, ns);
+    }
+    return char_cnt / best_ns * 1000.0;
+}
+
+void pool_dict_tree (string const& filename) {
+    cout << "# Encoding throughput of small inputs, tree based dictionaries\n"
+         << "# ==============================================================\n"
+         << "# chunk_size lz78_smru2 lzw_smru2 lzw_wmru lzw_mra" << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+
+    for (int64_t chunk_size : {64, 256, 1024, 4096, 16384}) {
+        std::vector<Buffer> chunks;
+        for (int64_t begin = 0; begin < char_cnt; begin += chunk_size) {
+            chunks.emplace_back();
+            BufferCharWriter(chunks.back()).put(BufferCharSlice(
+                input,
+                begin,
+                min(chunk_size, char_cnt - begin)
+            ));
+        }
+        cout << chunk_size
+             << " " << pool_dict_tree_sample(chunks, Lz78<Smru2>(4096))
+             << " " << pool_dict_tree_sample(chunks, Lzw<Smru2>(4096))
+             << " " << pool_dict_tree_sample(chunks, Lzw<Wmru>(4096))
+             << " " << pool_dict_tree_sample(chunks, Lzw<Mra>(4096))
+             << endl;
+    }
+}
@@ -0,0 +1,84 @@
+#include "prefix.h"
+#include <fstream>
+
+#include "../src/buffer.h"
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+#include "../src/mra_dict.h"
+#include "../src/preset_dict.h"
+#include "../src/smru_dict.h"
+
+// Number of chars the preset is trained on.
+static int64_t const SAMPLE_CHAR_CNT = 1 << 16;
+
+// Number of chars in a record.
+static int64_t const RECORD_CHAR_CNT = 256;
+
+template <typename LzType>
+void preset_sample (string const& name, Buffer const& input, int limit) {
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    LzType lz(limit);
+
+    auto t0 = system_clock::now();
+    PresetDict<LzType> preset(
+        lz,
+        BufferView(input).slice_chars(0, SAMPLE_CHAR_CNT)
+    );
+    auto t1 = system_clock::now();
+
+    // The records follow the sample.
+    std::vector<BufferView> records;
+    for (int64_t begin = SAMPLE_CHAR_CNT; begin < char_cnt;
+         begin += RECORD_CHAR_CNT) {
+        int64_t const length = min(RECORD_CHAR_CNT, char_cnt - begin);
+        records.push_back(BufferView(input).slice_chars(begin, length));
+    }
+
+    Buffer output;
+    int64_t input_bits = 0;
+    int64_t plain_bits = 0;
+    int64_t preset_bits = 0;
+    auto t2 = system_clock::now();
+    for (BufferView const& record : records) {
+        lz.encode(record, output);
+        plain_bits += output.size();
+        input_bits += record.size();
+    }
+    auto t3 = system_clock::now();
+    for (BufferView const& record : records) {
+        preset.encode(record, output);
+        preset_bits += output.size();
+    }
+    auto t4 = system_clock::now();
+
+    double const train_us = duration_cast<nanoseconds>(t1 - t0).count() / 1e3;
+    double const plain_ns = duration_cast<nanoseconds>(t3 - t2).count();
+    double const preset_ns = duration_cast<nanoseconds>(t4 - t3).count();
+    cout << name
+         << " " << limit
+         << " " << double(plain_bits) / input_bits
+         << " " << double(preset_bits) / input_bits
+         << " " << plain_ns / records.size() / 1e3
+         << " " << preset_ns / records.size() / 1e3
+         << " " << train_us
+         << endl;
+}
+
+void preset (string const& filename) {
+    cout << "# Small records with and without a preset dictionary\n"
+         << "# ==============================================================\n"
+         << "# algo limit plain_ratio preset_ratio plain_us_per_record "
+            "preset_us_per_record train_us" << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+
+    for (int limit : {1024, 4096}) {
+        preset_sample<Lz78<Smru>>("lz78-smru", input, limit);
+        preset_sample<Lzw<Smru>>("lzw-smru", input, limit);
+        preset_sample<Lz78<Mra>>("lz78-mra", input, limit);
+        preset_sample<Lzw<Mra>>("lzw-mra", input, limit);
+    }
+}
@@ -0,0 +1,103 @@
+#include "prefix.h"
+#include <fstream>
+
+#include "../src/buffer.h"
+#include "../src/mra_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+// Runs the LZ78 factorization loop over the input attached to `dict` char by
+// char, putting back whatever has been read past each match. The number of
+// chars read, including the ones read again, is stored in `read_cnt`.
+template <typename Dict>
+int64_t by_char (Dict& dict, int64_t& read_cnt) {
+    int64_t codeword_cnt = 0;
+    read_cnt = 0;
+    int64_t ahead = 0;
+    while (!dict.eob()) {
+        while (!dict.eob()) {
+            Match match = dict.try_char();
+            ++read_cnt;
+            ++ahead;
+            if (match.is_maximal()) {
+                ++codeword_cnt;
+                dict.put_back(ahead - match.length - 1);
+                ahead = 0;
+            }
+        }
+        if (ahead != 0) {
+            Match match = dict.fail_char();
+            ++codeword_cnt;
+            if (match.length != ahead) {
+                dict.put_back(ahead - match.length - 1);
+                ahead = 0;
+            }
+        }
+    }
+    return codeword_cnt;
+}
+
+// Runs the LZ78 factorization loop over the input attached to `dict` match by
+// match, never going back.
+template <typename Dict>
+int64_t by_match (Dict& dict) {
+    int64_t codeword_cnt = 0;
+    while (!dict.eob()) {
+        dict.next_match(true);
+        ++codeword_cnt;
+        if (!dict.eob())
+            dict.skip(1);
+    }
+    return codeword_cnt;
+}
+
+template <typename EncodeDictType>
+void single_pass_sample (string const& name, Buffer const& input, int limit) {
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+
+    auto t0 = system_clock::now();
+    EncodeDictType char_dict(input, limit, false);
+    int64_t read_cnt;
+    int64_t char_cnt_cw = by_char(char_dict, read_cnt);
+    auto t1 = system_clock::now();
+    EncodeDictType match_dict(input, limit, false);
+    int64_t match_cnt_cw = by_match(match_dict);
+    auto t2 = system_clock::now();
+    assert(char_cnt_cw == match_cnt_cw);
+
+    double char_ns = duration_cast<nanoseconds>(t1 - t0).count();
+    double match_ns = duration_cast<nanoseconds>(t2 - t1).count();
+    cout << name << " " << limit
+         << " " << char_ns / char_cnt
+         << " " << match_ns / char_cnt
+         << " " << double(read_cnt) / char_cnt
+         << " # " << char_cnt_cw << " " << match_cnt_cw << endl;
+}
+
+void single_pass_file (string const& filename) {
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+
+    cout << "# " << filename << endl;
+    for (int limit : {1000, 25000}) {
+        single_pass_sample<Smru::EncodeDict>("smru", input, limit);
+        single_pass_sample<Smru2::EncodeDict>("smru2", input, limit);
+        single_pass_sample<Wmru::EncodeDict>("wmru", input, limit);
+        single_pass_sample<Mra::EncodeDict>("mra", input, limit);
+    }
+}
+
+void single_pass (
+    string const& text_filename,
+    string const& binary_filename
+) {
+    cout << "# Char by char vs single pass matching\n"
+         << "# ==============================================================\n"
+         << "# dict limit by_char_ns_per_char by_match_ns_per_char"
+         << " by_char_reads_per_char" << endl;
+    assert(false);
+    single_pass_file(text_filename);
+    single_pass_file(binary_filename);
+}
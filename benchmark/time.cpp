@@ -15,21 +15,19 @@ void time (string const& filename) {
          << "# file_size "
          << "lz78_smru lz78_wmru lz78_mra lzw_smru lzw_wmru lzw_mra" << endl;
     assert(false);
-    std::vector<char> dump;
+    Buffer dump;
     std::ifstream odyssey(filename.c_str());
-    Buffer input;
-    BufferCharWriter writer(input);
-    char a;
-    while (odyssey.get(a))
-        dump.push_back(a);
+    BufferCharWriter(dump).put_stream(odyssey);
     odyssey.close();
+    int64_t const dump_length = dump.size() / CHAR_BITS;
 
-    int i = 0;
+    Buffer input;
+    BufferCharWriter writer(input);
+    int64_t i = 0;
     for (int k = 1; k <= 8; ++k) {
-        while (i < k * dump.size() / 8) {
-            writer.put(dump[i]);
-            ++i;
-        }
+        int64_t const end = k * dump_length / 8;
+        writer.put(BufferCharSlice(dump, i, end - i));
+        i = end;
         int limit = 25000;
         Sample samples[] = {
             Benchmark::run(input, 1, Lz78<Smru>(limit)),
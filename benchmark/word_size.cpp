@@ -0,0 +1,71 @@
+#include "prefix.h"
+#include <fstream>
+#include <vector>
+
+#include "../src/buffer.h"
+#include "../src/lz78.h"
+#include "../src/smru_dict.h"
+
+// A single field of the LZ codeword stream, i.e., either a codeword number or
+// an extending char, along with its width in bits.
+typedef pair<uint32_t, int> Field;
+
+template <typename Word>
+void word_size_sample (std::vector<Field> const& fields, int repeat_cnt) {
+    uint64_t bit_cnt = 0;
+    for (Field const& field : fields)
+        bit_cnt += field.second;
+    bit_cnt *= repeat_cnt;
+
+    auto t0 = system_clock::now();
+    BasicBuffer<Word> buffer;
+    BasicBufferBitWriter<Word> writer(buffer);
+    for (int k = 0; k < repeat_cnt; ++k) {
+        for (Field const& field : fields)
+            writer.put(field.first, field.second);
+    }
+    writer.flush();
+    auto t1 = system_clock::now();
+    BasicBufferBitReader<Word> reader(buffer);
+    uint32_t checksum = 0;
+    for (int k = 0; k < repeat_cnt; ++k) {
+        for (Field const& field : fields)
+            checksum += reader.get(field.second);
+    }
+    auto t2 = system_clock::now();
+
+    double write_ns = duration_cast<nanoseconds>(t1 - t0).count();
+    double read_ns = duration_cast<nanoseconds>(t2 - t1).count();
+    cout << 8 * sizeof(Word)
+         << " " << double(bit_cnt) / write_ns
+         << " " << double(bit_cnt) / read_ns
+         << " # " << checksum << endl;
+}
+
+void word_size (string const& filename) {
+    cout << "# Word size vs bit I/O throughput on the LZ codeword stream\n"
+         << "# ==============================================================\n"
+         << "# word_bits write_bits_per_ns read_bits_per_ns" << endl;
+    assert(false);
+    std::ifstream file(filename.c_str());
+    Buffer input;
+    BufferCharWriter(input).put_stream(file);
+    file.close();
+
+    // The fields are extracted from an actual LZ78 encoding, so that the
+    // widths follow the real distribution.
+    Lz78<Smru> lz78(25000);
+    Buffer output = lz78.encode(input);
+    int const codeword_no_length = lz78.codeword_bits() - CHAR_BITS;
+    std::vector<Field> fields;
+    BufferBitReader reader(output);
+    while (!reader.eob()) {
+        fields.emplace_back(reader.get(codeword_no_length), codeword_no_length);
+        if (!reader.eob())
+            fields.emplace_back(reader.get(CHAR_BITS), CHAR_BITS);
+    }
+
+    int const repeat_cnt = 20;
+    word_size_sample<uint32_t>(fields, repeat_cnt);
+    word_size_sample<uint64_t>(fields, repeat_cnt);
+}
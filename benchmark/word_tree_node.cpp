@@ -0,0 +1,162 @@
+#include "prefix.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/word_tree_node.h"
+
+// An allocator that counts the bytes it holds, for the map baseline.
+template <typename T>
+struct CountingAllocator {
+    typedef T value_type;
+
+    int64_t* bytes;
+
+    explicit CountingAllocator (int64_t* bytes) : bytes(bytes) {}
+
+    template <typename U>
+    CountingAllocator (CountingAllocator<U> const& a) : bytes(a.bytes) {}
+
+    T* allocate (size_t n) {
+        *bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate (T* p, size_t n) {
+        *bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator == (CountingAllocator<U> const& a) const {
+        return bytes == a.bytes;
+    }
+
+    template <typename U>
+    bool operator != (CountingAllocator<U> const& a) const {
+        return bytes != a.bytes;
+    }
+};
+
+// The node as it used to be, with the children in a hash map.
+struct MapNode {
+    typedef std::unordered_map<
+        char,
+        MapNode*,
+        std::hash<char>,
+        std::equal_to<char>,
+        CountingAllocator<pair<char const, MapNode*>>
+    > ChildMap;
+
+    int tag;
+    MapNode* parent;
+    ChildMap children;
+    char link_char;
+
+    MapNode (int64_t* bytes) :
+        tag(0),
+        parent(nullptr),
+        children(0, std::hash<char>(), std::equal_to<char>(),
+            ChildMap::allocator_type(bytes)),
+        link_char('\0')
+    {
+        /* Do nothing. */
+    }
+
+    MapNode* child (char a) {
+        auto it = children.find(a);
+        return it != children.end() ? it->second : nullptr;
+    }
+};
+
+// Number of parent nodes, each with the same number of children.
+static int const PARENT_CNT = 1 << 12;
+
+// Number of `child()` calls timed.
+static int const LOOKUP_CNT = 1 << 24;
+
+void word_tree_node_sample (int fan_out) {
+    // The labels of every parent are a random subset of the alphabet. Then
+    // the lookups go to random parents along random existing labels.
+    uint32_t state = 1;
+    auto random = [&state] () {
+        state = state * 1103515245 + 12345;
+        return state >> 8;
+    };
+    std::vector<std::vector<char>> labels(PARENT_CNT);
+    for (std::vector<char>& ls : labels) {
+        std::vector<char> alphabet;
+        for (int a = 0; a < CHAR_CNT; ++a)
+            alphabet.push_back(a);
+        for (int k = 0; k < fan_out; ++k) {
+            std::swap(alphabet[k], alphabet[k + random() % (CHAR_CNT - k)]);
+            ls.push_back(alphabet[k]);
+        }
+    }
+    std::vector<pair<int, char>> lookups;
+    for (int k = 0; k < LOOKUP_CNT; ++k) {
+        int const p = random() % PARENT_CNT;
+        lookups.emplace_back(p, labels[p][random() % fan_out]);
+    }
+    int64_t const node_cnt = int64_t(PARENT_CNT) * (fan_out + 1);
+
+    int64_t map_bytes = 0;
+    std::vector<std::unique_ptr<MapNode>> map_nodes;
+    for (int p = 0; p < PARENT_CNT; ++p)
+        map_nodes.emplace_back(new MapNode(&map_bytes));
+    for (int p = 0; p < PARENT_CNT; ++p) {
+        for (char a : labels[p]) {
+            map_nodes.emplace_back(new MapNode(&map_bytes));
+            map_nodes.back()->parent = map_nodes[p].get();
+            map_nodes.back()->link_char = a;
+            map_nodes[p]->children[a] = map_nodes.back().get();
+        }
+    }
+    map_bytes += node_cnt * sizeof(MapNode);
+
+    typedef WordTreeNode<int> Node;
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (int p = 0; p < PARENT_CNT; ++p)
+        nodes.emplace_back(new Node(0));
+    for (int p = 0; p < PARENT_CNT; ++p) {
+        for (char a : labels[p]) {
+            nodes.emplace_back(new Node(0));
+            nodes[p]->link_child(a, nodes.back().get());
+        }
+    }
+    int64_t node_bytes = node_cnt * sizeof(Node);
+    for (int p = 0; p < PARENT_CNT; ++p)
+        node_bytes += nodes[p]->child_bytes();
+
+    // The sums keep the lookups from being optimized away.
+    int64_t map_sum = 0;
+    auto t0 = system_clock::now();
+    for (auto const& l : lookups)
+        map_sum += map_nodes[l.first]->child(l.second)->link_char;
+    auto t1 = system_clock::now();
+    int64_t node_sum = 0;
+    for (auto const& l : lookups)
+        node_sum += nodes[l.first]->child(l.second)->link_char();
+    auto t2 = system_clock::now();
+    if (map_sum != node_sum)
+        cout << "# The lookups differ" << endl;
+
+    double const map_ns = duration_cast<nanoseconds>(t1 - t0).count();
+    double const node_ns = duration_cast<nanoseconds>(t2 - t1).count();
+    cout << fan_out
+         << " " << double(map_bytes) / node_cnt
+         << " " << double(node_bytes) / node_cnt
+         << " " << map_ns / LOOKUP_CNT
+         << " " << node_ns / LOOKUP_CNT
+         << endl;
+}
+
+void word_tree_node () {
+    cout << "# Word tree node children, hash map vs adaptive arrays\n"
+         << "# ==============================================================\n"
+         << "# fan_out map_bytes_per_node bytes_per_node map_ns_per_child "
+            "ns_per_child" << endl;
+    assert(false);
+    for (int fan_out : {1, 2, 3, 4, 8, 16, 32, 64, 128, 256})
+        word_tree_node_sample(fan_out);
+}
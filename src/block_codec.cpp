@@ -0,0 +1,85 @@
+#include "block_codec.h"
+
+#include <vector>
+
+#include "huffman.h"
+
+// Appends the contents of `view` to `writer` a word at a time.
+static void put_view (BufferBitWriter& writer, BufferView const& view) {
+    BufferBitReader reader(view);
+    while (reader.left() >= WORD_BITS)
+        writer.put(reader.get(WORD_BITS), WORD_BITS);
+    int const rest = reader.left();
+    writer.put(reader.get(rest), rest);
+}
+
+// BlockCodec
+// =============================================================================
+
+BlockCodec::BlockCodec (
+    Lz const& lz,
+    int64_t block_char_cnt,
+    ThreadPool& pool
+) :
+    m_lz(lz),
+    m_block_char_cnt(block_char_cnt),
+    m_pool(pool)
+{
+    assert(block_char_cnt > 0);
+}
+
+void BlockCodec::encode (BufferView const& input, Buffer& output) const {
+    assert(input.is_char_aligned());
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    int64_t const block_cnt = ceil_div(char_cnt, m_block_char_cnt);
+
+    std::vector<Buffer> blocks(block_cnt);
+    m_pool.run(block_cnt, [&] (int64_t i) {
+        int64_t const begin = i * m_block_char_cnt;
+        int64_t const length = min(m_block_char_cnt, char_cnt - begin);
+        // The intermediate buffer is recycled by the worker thread.
+        Buffer lz_output(RecyclingBufferAllocator::instance());
+        m_lz.encode(input.slice_chars(begin, length), lz_output);
+        Huffman::encode(lz_output, blocks[i]);
+    });
+
+    int64_t bit_cnt = HEADER_BITS + block_cnt * 64;
+    for (Buffer const& block : blocks)
+        bit_cnt += block.size();
+    output.clear();
+    output.reserve(bit_cnt);
+    BufferBitWriter writer(output);
+    writer.put64(char_cnt);
+    writer.put64(m_block_char_cnt);
+    for (Buffer const& block : blocks)
+        writer.put64(block.size());
+    for (Buffer const& block : blocks)
+        put_view(writer, block);
+    writer.flush();
+}
+
+void BlockCodec::decode (BufferView const& output, Buffer& input) const {
+    BufferBitReader reader(output);
+    int64_t const char_cnt = reader.get64();
+    int64_t const block_char_cnt = reader.get64();
+    int64_t const block_cnt = ceil_div(char_cnt, block_char_cnt);
+
+    // The index gives away where every block begins.
+    std::vector<int64_t> begins(block_cnt + 1);
+    begins[0] = HEADER_BITS + block_cnt * 64;
+    for (int64_t i = 0; i < block_cnt; ++i)
+        begins[i + 1] = begins[i] + reader.get64();
+
+    // The blocks are decoded right into their place in the output.
+    input.clear();
+    input.reserve(char_cnt * CHAR_BITS);
+    char* const dest = BufferCharWriter(input).append(char_cnt);
+    m_pool.run(block_cnt, [&] (int64_t i) {
+        int64_t const begin = i * block_char_cnt;
+        int64_t const length = min(block_char_cnt, char_cnt - begin);
+        int64_t const bit_cnt = begins[i + 1] - begins[i];
+        Buffer lz_output(RecyclingBufferAllocator::instance());
+        Huffman::decode(output.slice(begins[i], bit_cnt), lz_output);
+        m_lz.decode(lz_output, dest + begin, length);
+    });
+}
@@ -0,0 +1,79 @@
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+
+#include "prefix.h"
+
+#include "buffer.h"
+#include "lz.h"
+#include "thread_pool.h"
+
+// BlockCodec
+// =============================================================================
+//
+// Encodes the input in independent blocks of fixed size, so that they can be
+// processed in parallel. Every block gets a fresh dictionary and is encoded
+// first with LZ and then with `Huffman`. The blocks are spread over the
+// threads of a `ThreadPool`.
+//
+// Smaller blocks mean more parallelism, but also dictionaries that have less
+// input to learn from, hence worse compression.
+//
+// The encoding consists of:
+//
+//   * 64 bits holding the number of chars of the input;
+//   * 64 bits holding the number of chars in a block, all blocks but the last
+//     one being full;
+//   * the block index, i.e., 64 bits per block holding the size of its
+//     encoding in bits;
+//   * the encodings of the blocks, one after another.
+class BlockCodec {
+public:
+    // Constructs a codec that uses `lz` to encode blocks of `block_char_cnt`
+    // chars on `pool`. Both `lz` and `pool` have to outlive the codec.
+    BlockCodec (Lz const& lz, int64_t block_char_cnt, ThreadPool& pool);
+
+    // Returns the number of chars in a block.
+    int64_t block_char_cnt () const;
+
+    // Encodes the char aligned `input`.
+    Buffer encode (BufferView const& input) const;
+
+    // Encodes the char aligned `input` into `output`, discarding its previous
+    // contents but reusing its data array.
+    void encode (BufferView const& input, Buffer& output) const;
+
+    // Decodes `output`, which has to be encoded with the same kind of `Lz`.
+    // The block size is read from the encoding. The blocks are decoded on the
+    // pool, each of them right into its place in the output.
+    Buffer decode (BufferView const& output) const;
+
+    // Decodes `output` into `input`, discarding its previous contents but
+    // reusing its data array.
+    void decode (BufferView const& output, Buffer& input) const;
+
+private:
+    // Size of the fixed part of the header in bits.
+    static int const HEADER_BITS = 128;
+
+    Lz const& m_lz;
+    int64_t const m_block_char_cnt;
+    ThreadPool& m_pool;
+};
+
+inline int64_t BlockCodec::block_char_cnt () const {
+    return m_block_char_cnt;
+}
+
+inline Buffer BlockCodec::encode (BufferView const& input) const {
+    Buffer output;
+    encode(input, output);
+    return output;
+}
+
+inline Buffer BlockCodec::decode (BufferView const& output) const {
+    Buffer input;
+    decode(output, input);
+    return input;
+}
+
+#endif // BLOCK_CODEC_H
@@ -1,63 +1,126 @@
 #include "buffer.h"
 
-// Buffer
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+// BasicBuffer
 // =============================================================================
 
-Buffer::Buffer () :
-    m_data(new word[1]),
+template <typename Word>
+BasicBuffer<Word>::BasicBuffer () :
+    BasicBuffer(BasicBufferAllocator<Word>::standard())
+{
+    /* Do nothing. */
+}
+
+template <typename Word>
+BasicBuffer<Word>::BasicBuffer (BasicBufferAllocator<Word>& allocator) :
+    m_allocator(&allocator),
+    m_data(nullptr),
     m_capacity(1),
-    m_open_word_cnt(0),
+    m_open_word_cnt(1),
     m_size(0)
 {
-    push_back(NULL_WORD);
+    m_data = m_allocator->allocate(m_capacity);
+    m_data[0] = Traits::NULL_WORD;
 }
 
-Buffer::Buffer (Buffer&& buffer)
+template <typename Word>
+BasicBuffer<Word>::BasicBuffer (void const* data, int64_t char_cnt) :
+    m_allocator(nullptr),
+    m_data(static_cast<Word*>(const_cast<void*>(data))),
+    m_capacity(0),
+    m_open_word_cnt(ceil_div<int64_t>(char_cnt, Traits::CHARS)),
+    m_size(char_cnt * CHAR_BITS)
 {
+    assert(reinterpret_cast<uintptr_t>(data) % sizeof(Word) == 0);
+    assert(char_cnt >= 0);
+}
+
+template <typename Word>
+BasicBuffer<Word>::BasicBuffer (BasicBuffer&& buffer) :
+    m_allocator(nullptr),
+    m_data(nullptr),
+    m_capacity(0),
+    m_open_word_cnt(0),
+    m_size(0)
+{
+    swap(m_allocator, buffer.m_allocator);
     swap(m_data, buffer.m_data);
     swap(m_capacity, buffer.m_capacity);
     swap(m_open_word_cnt, buffer.m_open_word_cnt);
     swap(m_size, buffer.m_size);
 }
 
-Buffer::~Buffer () {
-    delete[] m_data;
+template <typename Word>
+BasicBuffer<Word>::~BasicBuffer () {
+    if (!is_borrowed())
+        release({m_data, m_capacity});
+}
+
+template <typename Word>
+void BasicBuffer<Word>::reserve (int64_t bit_cnt) {
+    // There is always one open word past the last full one.
+    release(adjust_capacity(bit_cnt / Traits::BITS + 1));
 }
 
-inline void Buffer::push_back (word data) {
-    delete[] adjust_capacity(m_open_word_cnt + 1);
+template <typename Word>
+void BasicBuffer<Word>::clear () {
+    assert(!is_borrowed());
+    m_data[0] = Traits::NULL_WORD;
+    m_open_word_cnt = 1;
+    m_size = 0;
+}
+
+template <typename Word>
+inline void BasicBuffer<Word>::push_back (Word data) {
+    release(adjust_capacity(m_open_word_cnt + 1));
     m_data[m_open_word_cnt] = data;
     ++m_open_word_cnt;
 }
 
-inline word* Buffer::adjust_capacity (int word_cnt) {
+template <typename Word>
+inline typename BasicBuffer<Word>::Storage
+BasicBuffer<Word>::adjust_capacity (int64_t word_cnt) {
+    assert(!is_borrowed());
     if (word_cnt <= m_capacity)
-        return nullptr;
-    word* old_data = m_data;
-    int old_capacity = m_capacity;
-    while (m_capacity < word_cnt)
-        m_capacity *= 2;
-    m_data = new word[m_capacity];
-    copy(old_data, old_data + old_capacity, m_data);
-    return old_data;
+        return {nullptr, 0};
+    Storage const old = {m_data, m_capacity};
+    m_capacity = max(word_cnt, 2 * m_capacity);
+    m_data = m_allocator->allocate(m_capacity);
+    copy(old.data, old.data + m_open_word_cnt, m_data);
+    return old;
+}
+
+template <typename Word>
+inline void BasicBuffer<Word>::release (Storage const& storage) {
+    if (storage.data != nullptr)
+        m_allocator->deallocate(storage.data, storage.capacity);
 }
 
-bool Buffer::operator == (Buffer const& buffer) const {
+template <typename Word>
+bool BasicBuffer<Word>::operator == (BasicBuffer const& buffer) const {
     if (m_size != buffer.m_size)
         return false;
-    for (int i = 0; i < m_open_word_cnt; ++i)
+    // Only the words holding some data are compared. The unused bits are
+    // always zero, but borrowed buffers lack the trailing open word.
+    int64_t const word_cnt = ceil_div<int64_t>(m_size, Traits::BITS);
+    for (int64_t i = 0; i < word_cnt; ++i)
         if (m_data[i] != buffer.m_data[i])
             return false;
     return true;
 }
 
-std::ostream& operator << (std::ostream& ostr, Buffer const& buffer) {
+template <typename Word>
+std::ostream&
+operator << (std::ostream& ostr, BasicBuffer<Word> const& buffer) {
     // This is intended only for debugging purposes so it doesn't have to be
     // effective.
-    BufferBitReader reader(buffer);
+    BasicBufferBitReader<Word> reader(buffer);
     int pos = 0;
     while (!reader.eob()) {
-        ostr << (reader.get(1) == NULL_WORD ? '0' : '1');
+        ostr << (reader.get(1) == Word(0) ? '0' : '1');
         if (++pos == 8) {
             ostr << ' ';
             pos = 0;
@@ -66,126 +129,300 @@ std::ostream& operator << (std::ostream& ostr, Buffer const& buffer) {
     return ostr;
 }
 
-// BufferBitReader
+// BasicBufferView
 // =============================================================================
 
-BufferBitReader::BufferBitReader(Buffer const& buffer) :
+template <typename Word>
+BasicBufferView<Word>::BasicBufferView () :
+    m_owner(),
+    m_data(nullptr),
+    m_begin(0),
+    m_size(0)
+{
+    /* Do nothing. */
+}
+
+template <typename Word>
+BasicBufferView<Word>::BasicBufferView (BasicBuffer<Word> const& buffer) :
+    m_owner(),
     m_data(buffer.m_data),
-    m_left(buffer.m_size),
-    m_pos(0),
-    m_offset(WORD_BITS)
+    m_begin(0),
+    m_size(buffer.m_size)
 {
-    /* Do nothing */
+    /* Do nothing. */
 }
 
-word BufferBitReader::get (int bit_cnt) {
-    assert(bit_cnt >= 0);
-    assert(bit_cnt <= WORD_BITS);
-    assert(bit_cnt <= m_left);
+template <typename Word>
+BasicBufferView<Word>::BasicBufferView (BasicBuffer<Word>&& buffer) :
+    BasicBufferView(
+        std::make_shared<BasicBuffer<Word> const>(std::move(buffer))
+    )
+{
+    /* Do nothing. */
+}
 
-    m_offset -= bit_cnt;
-    word result = rshift(m_data[m_pos], m_offset);
-    if (m_offset <= 0) {
-        m_offset += WORD_BITS;
-        ++m_pos;
-        result |= rshift(m_data[m_pos], m_offset);
+template <typename Word>
+BasicBufferView<Word>::BasicBufferView (
+    std::shared_ptr<BasicBuffer<Word> const> const& buffer
+) :
+    m_owner(buffer),
+    m_data(buffer->m_data),
+    m_begin(0),
+    m_size(buffer->m_size)
+{
+    /* Do nothing. */
+}
+
+template <typename Word>
+bool BasicBufferView<Word>::operator == (BasicBufferView const& view) const {
+    if (m_size != view.m_size)
+        return false;
+    BasicBufferBitReader<Word> reader1(*this);
+    BasicBufferBitReader<Word> reader2(view);
+    while (reader1.left() >= 64) {
+        if (reader1.peek(64) != reader2.peek(64))
+            return false;
+        reader1.consume(64);
+        reader2.consume(64);
     }
-    m_left -= bit_cnt;
-    return result & ~lshift(ONES_MASK, bit_cnt);
+    int const rest = reader1.left();
+    return reader1.peek(rest) == reader2.peek(rest);
 }
 
-// BufferBitWriter
+// BasicBufferBitReader
 // =============================================================================
 
-BufferBitWriter::BufferBitWriter(Buffer& buffer) :
-    m_buffer(buffer),
-    m_pos(buffer.m_size / WORD_BITS),
-    m_offset(WORD_BITS - buffer.m_size % WORD_BITS)
+template <typename Word>
+BasicBufferBitReader<Word>::BasicBufferBitReader(
+    BasicBufferView<Word> const& view
+) :
+    m_data(view.m_data),
+    // A borrowed buffer may lack the open word past the last full one, but
+    // there is always at least one word to load.
+    m_last(max<int64_t>(
+        ceil_div<int64_t>(view.m_begin + view.m_size, Traits::BITS) - 1,
+        view.m_begin / Traits::BITS
+    )),
+    m_end(view.m_begin + view.m_size),
+    m_pos(view.m_begin)
 {
     /* Do nothing */
 }
 
-void BufferBitWriter::put (word data, int bit_cnt) {
-    assert(bit_cnt >= 0);
-    assert(bit_cnt <= WORD_BITS);
-    assert((data & ~lshift(ONES_MASK, bit_cnt)) == data);
+// BasicBufferBitWriter
+// =============================================================================
+
+template <typename Word>
+BasicBufferBitWriter<Word>::BasicBufferBitWriter(BasicBuffer<Word>& buffer) :
+    m_buffer(buffer),
+    m_pos(buffer.m_size / Traits::BITS),
+    m_acc(buffer.m_data[m_pos]),
+    m_free(Traits::BITS - buffer.m_size % Traits::BITS)
+{
+    assert(!buffer.is_borrowed());
+}
 
-    m_offset -= bit_cnt;
-    m_buffer.m_data[m_pos] |= lshift(data, m_offset);
-    if (m_offset <= 0) {
-        m_offset += WORD_BITS;
-        ++m_pos;
-        m_buffer.push_back(lshift(data, m_offset));
-    }
-    m_buffer.m_size += bit_cnt;
+template <typename Word>
+BasicBufferBitWriter<Word>::~BasicBufferBitWriter () {
+    if (m_buffer.m_size == m_pos * Traits::BITS + Traits::BITS - m_free)
+        flush();
 }
 
-// BufferCharReader
+// BasicBufferCharReader
 // =============================================================================
 
-BufferCharReader::BufferCharReader (Buffer const& buffer) :
-    m_data(reinterpret_cast<char const*>(buffer.m_data)),
-    m_char_cnt(buffer.m_size / CHAR_BITS),
+template <typename Word>
+BasicBufferCharReader<Word>::BasicBufferCharReader (
+    BasicBufferView<Word> const& view
+) :
+    m_data(
+        reinterpret_cast<char const*>(view.m_data) + view.m_begin / CHAR_BITS
+    ),
+    m_last_word(Traits::NULL_WORD),
+    m_char_cnt(view.m_size / CHAR_BITS),
     m_pos(0)
 {
-    /* Do nothing */
+    assert(view.m_begin % CHAR_BITS == 0);
+    int64_t const last_bit_cnt = view.m_size % Traits::BITS;
+    if (last_bit_cnt == 0)
+        return;
+    int64_t const last_begin = view.m_begin + view.m_size - last_bit_cnt;
+    if (last_begin % Traits::BITS == 0) {
+        m_last_word = view.m_data[last_begin / Traits::BITS];
+    } else {
+        // The last word of a view that doesn't start on a word boundary isn't
+        // a word of the buffer. Only its whole chars are carried over, in
+        // memory order, and nothing past them is touched.
+        memcpy(
+            &m_last_word,
+            m_data + (view.m_size - last_bit_cnt) / CHAR_BITS,
+            last_bit_cnt / CHAR_BITS
+        );
+    }
 }
 
-// BufferCharWriter
+// BasicBufferCharWriter
 // =============================================================================
 
-BufferCharWriter::BufferCharWriter (Buffer& buffer) :
+template <typename Word>
+BasicBufferCharWriter<Word>::BasicBufferCharWriter (BasicBuffer<Word>& buffer) :
     m_buffer(buffer),
     m_pos(buffer.m_size / CHAR_BITS)
 {
     // Permit only properly aligned buffers.
     assert(buffer.m_size % CHAR_BITS == 0);
+    assert(!buffer.is_borrowed());
 }
 
-void BufferCharWriter::put (char data) {
+template <typename Word>
+void BasicBufferCharWriter<Word>::put (char data) {
     reinterpret_cast<char*>(m_buffer.m_data)[m_pos] = data;
     m_buffer.m_size += CHAR_BITS;
     ++m_pos;
-    if (m_buffer.m_open_word_cnt <= m_pos / WORD_CHARS)
-        m_buffer.push_back(NULL_WORD);
+    if (m_buffer.m_open_word_cnt <= m_pos / Traits::CHARS)
+        m_buffer.push_back(Traits::NULL_WORD);
+}
+
+template <typename Word>
+void BasicBufferCharWriter<Word>::put (string const& data) {
+    put(data.data(), data.size());
+}
+
+template <typename Word>
+void BasicBufferCharWriter<Word>::put (BufferCharSlice const& slice) {
+    put(slice.m_begin, slice.m_length);
+}
+
+template <typename Word>
+void BasicBufferCharWriter<Word>::put (char const* data, int64_t char_cnt) {
+    assert(char_cnt >= 0);
+    Storage old;
+    char* const dest = make_room(char_cnt, old);
+    if (char_cnt > 0)
+        memcpy(dest, data, char_cnt);
+    // The release of `old` is delayed until now, because `data` may point
+    // into `m_buffer` itself.
+    m_buffer.release(old);
+    commit(char_cnt);
+}
+
+template <typename Word>
+void BasicBufferCharWriter<Word>::put_copy (int64_t begin, int64_t length) {
+    assert(length >= 0);
+    assert(0 <= begin && (begin < m_pos || length == 0));
+    // Every round copies all the chars between `begin` and `m_pos`, which
+    // doubles their number if the copy runs into its destination.
+    while (true) {
+        int64_t const part = min(length, m_pos - begin);
+        put(reinterpret_cast<char const*>(m_buffer.m_data) + begin, part);
+        if (part == length)
+            return;
+        length -= part;
+    }
+}
+
+template <typename Word>
+char* BasicBufferCharWriter<Word>::append (int64_t char_cnt) {
+    assert(char_cnt >= 0);
+    Storage old;
+    char* const dest = make_room(char_cnt, old);
+    m_buffer.release(old);
+    commit(char_cnt);
+    return dest;
 }
 
-void BufferCharWriter::put (string const& data) {
-    // This method is intended for testing, so it doesn't have to be efficient.
-    for (char c : data)
-        put(c);
+template <typename Word>
+int64_t BasicBufferCharWriter<Word>::put_stream (std::istream& istr) {
+    int64_t total = 0;
+    while (istr) {
+        Storage old;
+        char* const dest = make_room(READ_CHUNK, old);
+        m_buffer.release(old);
+        istr.read(dest, READ_CHUNK);
+        commit(istr.gcount());
+        total += istr.gcount();
+    }
+    return total;
 }
 
-void BufferCharWriter::put (BufferCharSlice const& slice) {
-    int new_pos = m_pos + slice.m_length;
-    int new_open_word_cnt = new_pos / WORD_CHARS + 1;
-    word* const old_data = m_buffer.adjust_capacity(new_open_word_cnt);
-    if (m_buffer.m_open_word_cnt < new_open_word_cnt) {
-        // If new words are opened. The last one would end up with undefined
-        // least significant bits if not initialized.
-        m_buffer.m_data[new_open_word_cnt - 1] = NULL_WORD;
-        m_buffer.m_open_word_cnt = new_open_word_cnt;
+template <typename Word>
+int64_t BasicBufferCharWriter<Word>::put_fd (int fd) {
+    int64_t total = 0;
+    while (true) {
+        Storage old;
+        char* const dest = make_room(READ_CHUNK, old);
+        m_buffer.release(old);
+        ssize_t const read_cnt = read(fd, dest, READ_CHUNK);
+        if (read_cnt < 0 && errno == EINTR)
+            continue;
+        if (read_cnt < 0)
+            return -1;
+        if (read_cnt == 0)
+            return total;
+        commit(read_cnt);
+        total += read_cnt;
     }
-    copy(
-        slice.m_begin,
-        slice.m_begin + slice.m_length,
-        reinterpret_cast<char*>(m_buffer.m_data) + m_pos
-    );
-    // The deletion of `old_data` is delayed until now, because `slice` may
-    // come from `m_buffer` itself.
-    delete[] old_data;
-    m_buffer.m_size += slice.m_length * CHAR_BITS;
-    m_pos = new_pos;
-}
-
-void BufferCharWriter::put_last_word (word data, int bit_cnt) {
-    assert(m_pos % WORD_CHARS == 0);
-    assert(m_buffer.m_size % WORD_BITS == 0);
-    assert(0 <= bit_cnt && bit_cnt <= WORD_BITS);
+}
+
+template <typename Word>
+void BasicBufferCharWriter<Word>::put_last_word (Word data, int bit_cnt) {
+    assert(m_pos % Traits::CHARS == 0);
+    assert(m_buffer.m_size % Traits::BITS == 0);
+    assert(0 <= bit_cnt && bit_cnt <= Traits::BITS);
     m_buffer.m_data[m_buffer.m_open_word_cnt - 1] = data;
     m_buffer.m_size += bit_cnt;
-    if (bit_cnt == WORD_BITS) {
+    if (bit_cnt == Traits::BITS) {
         ++m_buffer.m_open_word_cnt;
-        m_buffer.adjust_capacity(m_buffer.m_open_word_cnt);
+        m_buffer.release(m_buffer.adjust_capacity(m_buffer.m_open_word_cnt));
     }
 }
+
+template <typename Word>
+char* BasicBufferCharWriter<Word>::make_room (
+    int64_t char_cnt,
+    Storage& old
+) {
+    int64_t const new_pos = m_pos + char_cnt;
+    // There is always one open word past the last full one.
+    old = m_buffer.adjust_capacity(new_pos / Traits::CHARS + 1);
+    return reinterpret_cast<char*>(m_buffer.m_data) + m_pos;
+}
+
+template <typename Word>
+void BasicBufferCharWriter<Word>::commit (int64_t char_cnt) {
+    m_pos += char_cnt;
+    m_buffer.m_size += char_cnt * CHAR_BITS;
+    int64_t const open_word_cnt = m_pos / Traits::CHARS + 1;
+    // The chars past the end would otherwise leave the last word with undefined
+    // least significant bits.
+    char* const chars = reinterpret_cast<char*>(m_buffer.m_data);
+    fill(chars + m_pos, chars + open_word_cnt * Traits::CHARS, 0);
+    m_buffer.m_open_word_cnt = max(m_buffer.m_open_word_cnt, open_word_cnt);
+}
+
+// Instantiations
+// =============================================================================
+//
+// Only the 32 and 64 bit words are supported.
+
+template class BasicBuffer<uint32_t>;
+template class BasicBufferView<uint32_t>;
+template class BasicBufferBitReader<uint32_t>;
+template class BasicBufferBitWriter<uint32_t>;
+template class BasicBufferCharReader<uint32_t>;
+template class BasicBufferCharWriter<uint32_t>;
+template std::ostream& operator << (
+    std::ostream& ostr,
+    BasicBuffer<uint32_t> const& buffer
+);
+
+template class BasicBuffer<uint64_t>;
+template class BasicBufferView<uint64_t>;
+template class BasicBufferBitReader<uint64_t>;
+template class BasicBufferBitWriter<uint64_t>;
+template class BasicBufferCharReader<uint64_t>;
+template class BasicBufferCharWriter<uint64_t>;
+template std::ostream& operator << (
+    std::ostream& ostr,
+    BasicBuffer<uint64_t> const& buffer
+);
@@ -2,199 +2,571 @@
 #define BUFFER_H
 
 #include "prefix.h"
+#include <cstring>
+#include <memory>
 #include <vector>
 
-// Buffer
+#include "buffer_allocator.h"
+
+template <typename Word> class BasicBufferView;
+template <typename Word> class BasicBufferBitReader;
+template <typename Word> class BasicBufferBitWriter;
+template <typename Word> class BasicBufferCharReader;
+template <typename Word> class BasicBufferCharWriter;
+class BufferCharSlice;
+
+// BasicBuffer
 // =============================================================================
 //
 // A buffer for data. Cannot be accessed directly; designated readers and
 // writers are needed.
-class Buffer {
+//
+// The data is stored in an array of unsigned words of type `Word`, which is
+// either `uint32_t` or `uint64_t`. Wider words let the bit readers and writers
+// cross word boundaries less often. Most of the code uses `Buffer`, which is
+// backed by the build-wide `word`.
+//
+// The data array comes from a `BasicBufferAllocator`, by default the standard
+// one. A buffer constructed with the recycling allocator, or a buffer that is
+// cleared and reused, lets repeated encoding run without heap allocations.
+template <typename Word>
+class BasicBuffer {
 public:
     // Constructs an empty buffer.
-    Buffer ();
+    BasicBuffer ();
 
-    Buffer (Buffer&& buffer);
+    // Constructs an empty buffer that obtains its data array from `allocator`.
+    // The allocator has to outlive the buffer.
+    explicit BasicBuffer (BasicBufferAllocator<Word>& allocator);
 
-    ~Buffer ();
+    // Constructs a read-only buffer over `char_cnt` chars of external memory
+    // starting at `data`, which has to be word aligned. Nothing is copied and
+    // the memory is never released by the buffer, so it has to outlive it.
+    //
+    // Readers can be attached to such buffer as usual, but writers cannot.
+    // This is how `MappedFile` exposes its contents.
+    BasicBuffer (void const* data, int64_t char_cnt);
+
+    BasicBuffer (BasicBuffer&& buffer);
+
+    ~BasicBuffer ();
 
     // Returns number of bits stored in the buffer.
-    int size () const;
+    int64_t size () const;
+
+    // Makes sure the buffer can grow to `bit_cnt` bits without reallocating.
+    // Writers attached to the buffer stay valid.
+    void reserve (int64_t bit_cnt);
+
+    // Empties the buffer but keeps its data array, so that it can be filled
+    // again without reallocating. Attached readers and writers are
+    // invalidated.
+    void clear ();
+
+    // Returns `true` if the buffer doesn't own its data, i.e., it has been
+    // constructed over external memory.
+    bool is_borrowed () const;
 
     // Returns `true` if the contents of `buffer` are equal to the contents of
     // this buffer.
-    bool operator == (Buffer const& buffer) const;
+    bool operator == (BasicBuffer const& buffer) const;
 
 private:
+    typedef WordTraits<Word> Traits;
+
+    // A data array along with its capacity.
+    struct Storage {
+        Word* data;
+        int64_t capacity;
+    };
+
+    // The allocator `m_data` comes from. Unused by borrowed buffers.
+    BasicBufferAllocator<Word>* m_allocator;
+
     // The underlying data array.
-    word* m_data;
+    Word* m_data;
 
-    // Number of words allocated by `m_data`.
-    int m_capacity;
+    // Number of words allocated by `m_data`. Borrowed buffers have no capacity
+    // at all.
+    int64_t m_capacity;
 
     // Number of initial words of `m_data` that are in use.
-    int m_open_word_cnt;
+    int64_t m_open_word_cnt;
 
     // Size of the buffer in bits.
-    int m_size;
+    int64_t m_size;
 
     // Opens a new cell of `m_data` and initiates it with value `data`.
-    void push_back (word data);
+    void push_back (Word data);
 
     // Makes sure `m_data` is able to store given number of words. Reallocates
-    // if necessary and returns the pointer to the old `m_data` which has to be
-    // released by the caller. If no reallocation is done, `nullptr` is
-    // returned.
+    // if necessary and returns the old storage which has to be passed to
+    // `release()` by the caller. If no reallocation is done, the returned
+    // storage is null. The capacity at least doubles on reallocation, and only
+    // the open words are carried over.
     //
     // The reason not to release the old `m_data` automatically is to allow
     // additional processing between the creation of new `m_data` and the
     // deletion of the old one. This is used in
-    // `BufferCharWriter::put(BufferCharSlice)`.
-    word* adjust_capacity (int word_cnt);
+    // `BufferCharWriter::put(char const*, int64_t)`.
+    Storage adjust_capacity (int64_t word_cnt);
+
+    // Returns `storage` to the allocator, unless it is null.
+    void release (Storage const& storage);
 
-    friend class BufferBitReader;
-    friend class BufferBitWriter;
-    friend class BufferCharReader;
-    friend class BufferCharWriter;
+    friend class BasicBufferView<Word>;
+    friend class BasicBufferBitReader<Word>;
+    friend class BasicBufferBitWriter<Word>;
+    friend class BasicBufferCharReader<Word>;
+    friend class BasicBufferCharWriter<Word>;
     friend class BufferCharSlice;
 
-    friend std::ostream& operator << (std::ostream& ostr, Buffer const& buffer);
+    template <typename W>
+    friend std::ostream& operator << (
+        std::ostream& ostr,
+        BasicBuffer<W> const& buffer
+    );
 };
 
-inline int Buffer::size () const {
+template <typename Word>
+inline int64_t BasicBuffer<Word>::size () const {
     return m_size;
 }
 
+template <typename Word>
+inline bool BasicBuffer<Word>::is_borrowed () const {
+    return m_capacity == 0;
+}
+
 // Pretty printing of buffer in binary form.
-std::ostream& operator << (std::ostream& ostr, Buffer const& buffer);
+template <typename Word>
+std::ostream& operator << (std::ostream& ostr, BasicBuffer<Word> const& buffer);
 
-// BufferBitReader
+// BasicBufferView
+// =============================================================================
+//
+// An immutable range of bits of some buffer. Views are cheap to copy and to
+// slice, as they never copy the data itself. Readers, `Lz::encode()` and the
+// decoders accept views, and every buffer converts to one implicitly.
+//
+// A view either shares the ownership of its buffer, in which case the buffer is
+// released together with the last view referring to it, or it merely borrows
+// the buffer, like a view obtained from an lvalue `BasicBuffer` does. In the
+// latter case the buffer has to outlive the view and must not be altered in
+// the meantime.
+template <typename Word>
+class BasicBufferView {
+public:
+    // Constructs an empty view.
+    BasicBufferView ();
+
+    // Constructs a view of the whole `buffer` that doesn't own it.
+    BasicBufferView (BasicBuffer<Word> const& buffer);
+
+    // Constructs a view of the whole `buffer`, taking over its contents. The
+    // data array is moved, not copied.
+    BasicBufferView (BasicBuffer<Word>&& buffer);
+
+    // Constructs a view of the whole `*buffer` that shares its ownership. To
+    // share a buffer owned by something else, e.g., a `MappedFile`, use the
+    // aliasing constructor of `std::shared_ptr`.
+    BasicBufferView (std::shared_ptr<BasicBuffer<Word> const> const& buffer);
+
+    // Returns number of bits in the view.
+    int64_t size () const;
+
+    // Returns `true` if the view starts on a char boundary of its buffer and
+    // spans whole chars, so that it can be read with a char reader.
+    bool is_char_aligned () const;
+
+    // Returns a view of `bit_cnt` bits starting `begin` bits into this view.
+    // The result shares the ownership of the buffer with this view.
+    BasicBufferView slice (int64_t begin, int64_t bit_cnt) const;
+
+    // Returns a view of `char_cnt` chars starting `begin` chars into this view.
+    BasicBufferView slice_chars (int64_t begin, int64_t char_cnt) const;
+
+    // Returns `true` if the bits of the two views are equal.
+    bool operator == (BasicBufferView const& view) const;
+
+private:
+    typedef WordTraits<Word> Traits;
+
+    // The owned buffer, or null if the buffer is borrowed.
+    std::shared_ptr<BasicBuffer<Word> const> m_owner;
+
+    // The data array of the buffer.
+    Word const* m_data;
+
+    // Index of the first bit of the view within `m_data`.
+    int64_t m_begin;
+
+    // Number of bits in the view.
+    int64_t m_size;
+
+    friend class BasicBufferBitReader<Word>;
+    friend class BasicBufferCharReader<Word>;
+    friend class BufferCharSlice;
+};
+
+template <typename Word>
+inline int64_t BasicBufferView<Word>::size () const {
+    return m_size;
+}
+
+template <typename Word>
+inline bool BasicBufferView<Word>::is_char_aligned () const {
+    return m_begin % CHAR_BITS == 0 && m_size % CHAR_BITS == 0;
+}
+
+template <typename Word>
+inline BasicBufferView<Word>
+BasicBufferView<Word>::slice (int64_t begin, int64_t bit_cnt) const {
+    assert(0 <= begin && 0 <= bit_cnt && begin + bit_cnt <= m_size);
+    BasicBufferView result(*this);
+    result.m_begin += begin;
+    result.m_size = bit_cnt;
+    return result;
+}
+
+template <typename Word>
+inline BasicBufferView<Word>
+BasicBufferView<Word>::slice_chars (int64_t begin, int64_t char_cnt) const {
+    return slice(begin * CHAR_BITS, char_cnt * CHAR_BITS);
+}
+
+// BasicBufferBitReader
 // =============================================================================
 //
 // A buffer reader that allows reading individual bits.
-class BufferBitReader {
+//
+// The reader sees the buffer through a 64 bit window starting at the read
+// position. The window is assembled from the words it overlaps with a fixed
+// sequence of loads and shifts, so neither `peek()` nor `get()` branch on word
+// boundaries. The loads never reach past the last word holding data, which
+// makes the reader safe on borrowed buffers too.
+template <typename Word>
+class BasicBufferBitReader {
 public:
-    // Constructs a bit reader attached to given buffer.
+    // Constructs a bit reader attached to given view. Any buffer can be
+    // passed as well.
     //
-    // **Warning:** The reader is valid only for as long as `buffer` is not
+    // **Warning:** The reader is valid only for as long as the buffer is not
     // altered.
-    explicit BufferBitReader (Buffer const& buffer);
+    explicit BasicBufferBitReader (BasicBufferView<Word> const& view);
+
+    // Returns the next `bit_cnt` bits of the buffer without advancing the read
+    // position. Up to 64 bits can be peeked regardless of `Word`. Bits past
+    // the end of the buffer are unspecified.
+    uint64_t peek (int bit_cnt) const;
+
+    // Advances the read position by `bit_cnt` bits.
+    void consume (int bit_cnt);
 
-    // Rteurns the next `bit_cnt` bits of the buffer and advances the read
-    // position.
-    word get (int bit_cnt);
+    // Returns the next `bit_cnt` bits of the buffer and advances the read
+    // position. The value `bit_cnt` may not exceed the number of bits in
+    // `Word`.
+    Word get (int bit_cnt);
+
+    // Reads a 64 bit value written with `BasicBufferBitWriter::put64()`.
+    uint64_t get64 ();
+
+    // Returns number of bits left to read.
+    int64_t left () const;
 
     // Returns `true` if there is no more data to read.
     bool eob () const;
 
 private:
+    typedef WordTraits<Word> Traits;
+
     // The data array of the attached buffer.
-    word const* m_data;
+    Word const* m_data;
+
+    // Index of the last word of `m_data` that may be loaded.
+    int64_t m_last;
 
-    // Number of words left to read.
-    int m_left;
+    // Index of the bit past the end of the view.
+    int64_t m_end;
 
-    // Index of the current word within `m_data` to start reading from on a call
-    // to `get()`.
-    int m_pos;
+    // Index of the next bit to read.
+    int64_t m_pos;
 
-    // Index of the least significant bit within the current word (indicated by
-    // `m_pos`) to start reading from on a call to `get()`.
-    int m_offset;
+    // Returns the 64 bits starting at `m_pos`, the first one being the most
+    // significant.
+    uint64_t window () const;
 };
 
-inline bool BufferBitReader::eob () const {
-    return m_left <= 0;
+template <>
+inline uint64_t BasicBufferBitReader<uint64_t>::window () const {
+    int64_t const i = m_pos / 64;
+    int const offset = m_pos % 64;
+    // At the end of the view the read position can lie past the last word.
+    uint64_t const high = m_data[min(i, m_last)];
+    uint64_t const low = m_data[min(i + 1, m_last)];
+    // Shifting by the full width is undefined, hence the two steps.
+    return (high << offset) | ((low >> 1) >> (63 - offset));
 }
 
-// BufferBitWriter
+template <>
+inline uint64_t BasicBufferBitReader<uint32_t>::window () const {
+    int64_t const i = m_pos / 32;
+    int const offset = m_pos % 32;
+    uint64_t const high = m_data[min(i, m_last)];
+    uint64_t const mid = m_data[min(i + 1, m_last)];
+    uint64_t const low = m_data[min(i + 2, m_last)];
+    return (((high << 32) | mid) << offset) | (low >> (32 - offset));
+}
+
+template <typename Word>
+inline uint64_t BasicBufferBitReader<Word>::peek (int bit_cnt) const {
+    assert(bit_cnt >= 0);
+    assert(bit_cnt <= 64);
+    return bit_cnt == 0 ? 0 : window() >> (64 - bit_cnt);
+}
+
+template <typename Word>
+inline void BasicBufferBitReader<Word>::consume (int bit_cnt) {
+    assert(bit_cnt >= 0);
+    assert(bit_cnt <= left());
+    m_pos += bit_cnt;
+}
+
+template <typename Word>
+inline Word BasicBufferBitReader<Word>::get (int bit_cnt) {
+    assert(bit_cnt <= Traits::BITS);
+    Word const result = peek(bit_cnt);
+    consume(bit_cnt);
+    return result;
+}
+
+template <typename Word>
+inline uint64_t BasicBufferBitReader<Word>::get64 () {
+    uint64_t const result = peek(64);
+    consume(64);
+    return result;
+}
+
+template <typename Word>
+inline int64_t BasicBufferBitReader<Word>::left () const {
+    return m_end - m_pos;
+}
+
+template <typename Word>
+inline bool BasicBufferBitReader<Word>::eob () const {
+    return m_pos >= m_end;
+}
+
+// BasicBufferBitWriter
 // =============================================================================
 //
 // A buffer writer that allows appending individual bits.
-class BufferBitWriter {
+//
+// The bits are gathered in an accumulator word and only whole words are stored
+// in the buffer. The size of the buffer is updated immediately, but the
+// partially filled last word reaches the buffer only on `flush()`, which is
+// also called on destruction. Therefore, nothing should read the buffer before
+// the writer is flushed, and no other writer should be attached to the buffer
+// in the meantime.
+template <typename Word>
+class BasicBufferBitWriter {
 public:
     // Constructs a bit writer attached to given buffer.
-    BufferBitWriter (Buffer& buffer);
+    BasicBufferBitWriter (BasicBuffer<Word>& buffer);
+
+    // Flushes the writer, unless the buffer has been written to by some other
+    // writer since the last `put()`.
+    ~BasicBufferBitWriter ();
 
     // Appends `bit_count` least significant bits of `data` to the buffer. The
-    // value `bit_count` may not exceed `WORD_BITS`.
-    void put (word data, int bit_cnt);
+    // value `bit_count` may not exceed the number of bits in `Word`.
+    void put (Word data, int bit_cnt);
+
+    // Appends two fields at once, as if `put(data1, bit_cnt1)` and
+    // `put(data2, bit_cnt2)` were called in turn. If the fields fit in a single
+    // word, which for 64 bit words is the case for a codeword number and an
+    // extending char, this costs the same as a single `put()`.
+    void put2 (Word data1, int bit_cnt1, Word data2, int bit_cnt2);
+
+    // Appends a 64 bit value. Unlike `put()`, this doesn't depend on the width
+    // of `Word`.
+    void put64 (uint64_t data);
+
+    // Stores the partially filled last word in the buffer.
+    void flush ();
 
 private:
+    typedef WordTraits<Word> Traits;
+
     // The attached buffer.
-    Buffer& m_buffer;
+    BasicBuffer<Word>& m_buffer;
+
+    // Index of the word within `m_buffer.m_data` the accumulator is going to
+    // be stored to.
+    int64_t m_pos;
+
+    // The accumulator. Its most significant bits hold the bits put so far
+    // into the current word, the rest is zero.
+    Word m_acc;
 
-    // Index of the current word within `m_buffer.m_data` to start writing to on
-    // a call to `put()`.
-    int m_pos;
+    // Number of least significant bits of `m_acc` that are still free. Always
+    // positive.
+    int m_free;
 
-    // Index of the least significant bit within the current word (indicated by
-    // `m_pos`) to start writing to on a call to `put()`.
-    int m_offset;
+    // Stores the full accumulator and moves on to the next word, growing the
+    // buffer if needed.
+    void emit ();
 };
 
-// BufferCharReader
+template <typename Word>
+inline void BasicBufferBitWriter<Word>::put (Word data, int bit_cnt) {
+    assert(bit_cnt >= 0);
+    assert(bit_cnt <= Traits::BITS);
+    assert((data & ~lshift(Traits::ONES_MASK, bit_cnt)) == data);
+
+    // An empty field would shift by the full width below if the accumulator
+    // is empty, which is undefined.
+    if (bit_cnt == 0)
+        return;
+    m_buffer.m_size += bit_cnt;
+    if (bit_cnt < m_free) {
+        m_free -= bit_cnt;
+        m_acc |= data << m_free;
+    } else {
+        // The field doesn't fit in the current word. Its high bits complete the
+        // accumulator and the remaining `spill` bits start the next word.
+        int const spill = bit_cnt - m_free;
+        m_acc |= data >> spill;
+        emit();
+        m_free = Traits::BITS - spill;
+        // Shifting by the full width is undefined, hence the two steps.
+        m_acc = (data << 1) << (m_free - 1);
+    }
+}
+
+template <typename Word>
+inline void BasicBufferBitWriter<Word>::put2 (
+    Word data1,
+    int bit_cnt1,
+    Word data2,
+    int bit_cnt2
+) {
+    if (bit_cnt1 + bit_cnt2 <= Traits::BITS && bit_cnt2 < Traits::BITS) {
+        put((data1 << bit_cnt2) | data2, bit_cnt1 + bit_cnt2);
+    } else {
+        put(data1, bit_cnt1);
+        put(data2, bit_cnt2);
+    }
+}
+
+template <typename Word>
+inline void BasicBufferBitWriter<Word>::put64 (uint64_t data) {
+    put(Word(data >> INT_BITS), INT_BITS);
+    put(Word(data & 0xFFFFFFFF), INT_BITS);
+}
+
+template <typename Word>
+inline void BasicBufferBitWriter<Word>::flush () {
+    m_buffer.m_data[m_pos] = m_acc;
+}
+
+template <typename Word>
+inline void BasicBufferBitWriter<Word>::emit () {
+    m_buffer.m_data[m_pos] = m_acc;
+    ++m_pos;
+    // The buffer always keeps an open word past the last full one.
+    if (m_pos == m_buffer.m_capacity)
+        m_buffer.release(m_buffer.adjust_capacity(m_pos + 1));
+    m_buffer.m_open_word_cnt = m_pos + 1;
+}
+
+// BasicBufferCharReader
 // =============================================================================
 //
 // A buffer reader that allows reading char by char.
-class BufferCharReader {
+template <typename Word>
+class BasicBufferCharReader {
 public:
-    // Constructs a char reader attached to given buffer.
+    // Constructs a char reader attached to given view, which has to start on
+    // a char boundary. Any buffer can be passed as well.
     //
-    // **Warning:** The reader is valid only for as long as `buffer` is not
+    // **Warning:** The reader is valid only for as long as the buffer is not
     // altered.
-    explicit BufferCharReader (Buffer const& buffer);
+    explicit BasicBufferCharReader (BasicBufferView<Word> const& view);
 
     // Returns the next char from the attached buffer.
     char get ();
 
     // Decreases the read position by `char_cnt` characters.
-    void put_back (int char_cnt);
+    void put_back (int64_t char_cnt);
+
+    // Increases the read position by `char_cnt` characters, as if they were
+    // read and ignored.
+    void skip (int64_t char_cnt);
 
     // Returns `true` if there is no more data to read.
     bool eob () const;
 
     // Return the index of the last character read from buffer. Before anything
     // is read, the result is `-1`.
-    int pos () const;
+    int64_t pos () const;
 
     // If one is reading a buffer that is not created with `CharBufferWriter`,
     // the last word doesn't make sense and has to be handled explicityly. This
-    // method returns that last word as a workaround.
-    word last_word () const;
+    // method returns that last word as a workaround. If the buffer ends on
+    // a word boundary, the result is `0`. For views, words are counted from
+    // the beginning of the view.
+    Word last_word () const;
 
 private:
+    typedef WordTraits<Word> Traits;
+
     // The data array of the attached buffer.
     char const* m_data;
 
+    // The partially filled last word of the attached view. It is captured
+    // upfront, because it needn't be addressable in borrowed buffers.
+    Word m_last_word;
+
     // Number of characters stored in `m_data`.
-    int m_char_cnt;
+    int64_t m_char_cnt;
 
     // Index of the current char within `m_data` to be read from on a call to
     // `get()`. Cannot exceed `m_char_cnt`.
-    int m_pos;
+    int64_t m_pos;
 };
 
-inline char BufferCharReader::get () {
+template <typename Word>
+inline char BasicBufferCharReader<Word>::get () {
     assert(m_pos < m_char_cnt);
     return m_data[m_pos++];
 }
 
-inline void BufferCharReader::put_back (int char_cnt) {
+template <typename Word>
+inline void BasicBufferCharReader<Word>::put_back (int64_t char_cnt) {
     assert(0 <= char_cnt && char_cnt <= m_pos);
     m_pos -= char_cnt;
 }
 
-inline bool BufferCharReader::eob () const {
+template <typename Word>
+inline void BasicBufferCharReader<Word>::skip (int64_t char_cnt) {
+    assert(0 <= char_cnt && char_cnt <= m_char_cnt - m_pos);
+    m_pos += char_cnt;
+}
+
+template <typename Word>
+inline bool BasicBufferCharReader<Word>::eob () const {
     return m_pos >= m_char_cnt;
 }
 
-inline int BufferCharReader::pos () const {
+template <typename Word>
+inline int64_t BasicBufferCharReader<Word>::pos () const {
     return m_pos - 1;
 }
 
-inline word BufferCharReader::last_word () const {
-    return reinterpret_cast<word const*>(m_data)[m_char_cnt / WORD_CHARS];
+template <typename Word>
+inline Word BasicBufferCharReader<Word>::last_word () const {
+    return m_last_word;
 }
 
 // BufferCharSlice
@@ -211,13 +583,31 @@ public:
     //
     // **Warning:** The slice is only valid for as long as `buffer` is not
     // altered.
-    BufferCharSlice (Buffer const& buffer, int begin, int length);
+    template <typename Word>
+    BufferCharSlice (
+        BasicBuffer<Word> const& buffer,
+        int64_t begin,
+        int64_t length
+    );
+
+    // Same as above, with `begin` counted from the beginning of `view`, which
+    // has to start on a char boundary. The slice doesn't share the ownership
+    // of the buffer, so some view has to keep it alive.
+    template <typename Word>
+    BufferCharSlice (
+        BasicBufferView<Word> const& view,
+        int64_t begin,
+        int64_t length
+    );
 
     // Returns length of the slice.
-    int length () const;
+    int64_t length () const;
 
     // Retrieves the `i`th character of the slice.
-    char operator [] (int i) const;
+    char operator [] (int64_t i) const;
+
+    // Returns the slice of `length` chars of this slice, starting at `begin`.
+    BufferCharSlice slice (int64_t begin, int64_t length) const;
 
 private:
     // Starting address of the slice. This points directly into the `m_data`
@@ -225,14 +615,18 @@ private:
     char const* m_begin;
 
     // Length of the slice (in chars).
-    int m_length;
+    int64_t m_length;
 
-    friend class BufferCharWriter;
+    template <typename Word> friend class BasicBufferCharWriter;
     friend bool operator == (
         BufferCharSlice const& slice1,
         BufferCharSlice const& slice2
     );
     friend bool operator == (string const& s, BufferCharSlice const& slice);
+    friend int64_t common_prefix_length (
+        BufferCharSlice const& slice1,
+        BufferCharSlice const& slice2
+    );
     friend std::ostream& operator << (
         std::ostream& ostr,
         BufferCharSlice const& slice
@@ -246,27 +640,81 @@ inline BufferCharSlice::BufferCharSlice () :
     /* Do nothing. */
 }
 
+template <typename Word>
 inline BufferCharSlice::BufferCharSlice (
-    Buffer const& buffer,
-    int begin,
-    int length
+    BasicBuffer<Word> const& buffer,
+    int64_t begin,
+    int64_t length
 ) :
     m_begin(reinterpret_cast<char const*>(buffer.m_data) + begin),
-    m_length(max(0, length))
+    m_length(max<int64_t>(0, length))
 {
     assert(begin < buffer.m_size / CHAR_BITS || m_length == 0);
     assert(begin + m_length <= buffer.m_size / CHAR_BITS);
 }
 
-inline int BufferCharSlice::length () const {
+template <typename Word>
+inline BufferCharSlice::BufferCharSlice (
+    BasicBufferView<Word> const& view,
+    int64_t begin,
+    int64_t length
+) :
+    m_begin(
+        reinterpret_cast<char const*>(view.m_data) +
+        view.m_begin / CHAR_BITS + begin
+    ),
+    m_length(max<int64_t>(0, length))
+{
+    assert(view.m_begin % CHAR_BITS == 0);
+    assert(begin < view.m_size / CHAR_BITS || m_length == 0);
+    assert(begin + m_length <= view.m_size / CHAR_BITS);
+}
+
+inline int64_t BufferCharSlice::length () const {
     return m_length;
 }
 
-inline char BufferCharSlice::operator [] (int i) const {
+inline char BufferCharSlice::operator [] (int64_t i) const {
     assert(0 <= i && i < m_length);
     return m_begin[i];
 }
 
+inline BufferCharSlice
+BufferCharSlice::slice (int64_t begin, int64_t length) const {
+    assert(0 <= begin && begin <= m_length);
+    assert(begin + length <= m_length);
+    BufferCharSlice result;
+    result.m_begin = m_begin + begin;
+    result.m_length = max<int64_t>(0, length);
+    return result;
+}
+
+// Returns the length of the longest common prefix of `slice1` and `slice2`.
+// The slices are compared eight chars at a time.
+inline int64_t common_prefix_length (
+    BufferCharSlice const& slice1,
+    BufferCharSlice const& slice2
+) {
+    int64_t const length = min(slice1.m_length, slice2.m_length);
+    int64_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t chars1;
+        uint64_t chars2;
+        memcpy(&chars1, slice1.m_begin + i, 8);
+        memcpy(&chars2, slice2.m_begin + i, 8);
+        if (chars1 != chars2) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return i + __builtin_ctzll(chars1 ^ chars2) / CHAR_BITS;
+#else
+            return i + __builtin_clzll(chars1 ^ chars2) / CHAR_BITS;
+#endif
+        }
+    }
+    while (i < length && slice1.m_begin[i] == slice2.m_begin[i])
+        ++i;
+    return i;
+}
+
 inline bool
 operator == (BufferCharSlice const& slice1, BufferCharSlice const& slice2) {
     return
@@ -288,14 +736,15 @@ operator << (std::ostream& ostr, BufferCharSlice const& slice) {
     return ostr << string(slice.m_begin, slice.m_length);
 }
 
-// BufferCharWriter
+// BasicBufferCharWriter
 // =============================================================================
 //
 // A buffer writer that allows writing with char resolution.
-class BufferCharWriter {
+template <typename Word>
+class BasicBufferCharWriter {
 public:
     // Constructs a char writer attached to given buffer.
-    explicit BufferCharWriter (Buffer& buffer);
+    explicit BasicBufferCharWriter (BasicBuffer<Word>& buffer);
 
     // Appends a char to the buffer.
     void put (char data);
@@ -307,16 +756,177 @@ public:
     // comes from the same buffer it is being written to.
     void put (BufferCharSlice const& slice);
 
+    // Appends `char_cnt` chars starting at `data` with a single copy. As with
+    // slices, `data` may point into the buffer itself.
+    void put (char const* data, int64_t char_cnt);
+
+    // Appends `length` chars already written to the buffer, starting at char
+    // `begin`. The chars are copied one after another, so the copy may run
+    // into its own destination and repeat the last `pos - begin` chars.
+    void put_copy (int64_t begin, int64_t length);
+
+    // Appends `char_cnt` chars of unspecified value and returns their address,
+    // so that the caller can fill them in afterwards, possibly from several
+    // threads. The address is valid until the buffer is altered.
+    char* append (int64_t char_cnt);
+
+    // Appends everything that is left in `istr`, reading straight into the
+    // buffer. Returns the number of chars appended.
+    int64_t put_stream (std::istream& istr);
+
+    // Appends everything that is left in the file descriptor `fd`, reading
+    // straight into the buffer. Returns the number of chars appended, or -1 if
+    // reading failed, in which case the chars read so far stay appended.
+    int64_t put_fd (int fd);
+
     // TODO doc
-    void put_last_word (word data, int bit_cnt);
+    void put_last_word (Word data, int bit_cnt);
 
 private:
+    typedef WordTraits<Word> Traits;
+
+    // Number of chars `put_stream()` and `put_fd()` make room for at a time.
+    static int64_t const READ_CHUNK = 1 << 16;
+
     // The attached buffer.
-    Buffer& m_buffer;
+    BasicBuffer<Word>& m_buffer;
 
     // Index of the current character within `m_buffer.m_data` to start writing
     // to on a call to `put()`.
-    int m_pos;
+    int64_t m_pos;
+
+    typedef typename BasicBuffer<Word>::Storage Storage;
+
+    // Makes sure `char_cnt` chars can be stored past `m_pos` and returns where
+    // they go. Like `BasicBuffer::adjust_capacity()`, yields the previous
+    // storage in `old` for the caller to release.
+    char* make_room (int64_t char_cnt, Storage& old);
+
+    // Accounts for `char_cnt` chars stored past `m_pos` and clears the rest of
+    // the last word.
+    void commit (int64_t char_cnt);
+};
+
+// CharArrayWriter
+// =============================================================================
+//
+// Writes chars one after another into a fixed array of memory, such as a part
+// of a buffer obtained with `BufferCharWriter::append()`. It has the same
+// `put()` and `put_copy()` methods as `BufferCharWriter`, so that decoders can
+// use either.
+//
+// The copies go in chunks of `CHUNK` chars, even if fewer are asked for, as
+// long as the array extends far enough past the copied chars. The chars written
+// beyond them are overwritten by what follows, so the array is best given
+// `CHUNK` chars of slack past its end. Without the slack only the copies close
+// to the end are done char by char.
+class CharArrayWriter {
+public:
+    // Number of chars copied at a time.
+    static int const CHUNK = 16;
+
+    // Constructs a writer that fills `char_cnt` chars starting at `data`. The
+    // `slack_cnt` chars following them may be written with unspecified values.
+    CharArrayWriter (char* data, int64_t char_cnt, int64_t slack_cnt = 0);
+
+    // Appends a char.
+    void put (char data);
+
+    // Appends `length` chars already written to the array, starting at char
+    // `begin`. The chars are copied one after another, so the copy may run
+    // into its own destination and repeat the last `pos() - begin` chars.
+    void put_copy (int64_t begin, int64_t length);
+
+    // Returns the number of chars written so far.
+    int64_t pos () const;
+
+private:
+    char* const m_data;
+    int64_t const m_char_cnt;
+
+    // Number of chars that can be written, the slack included.
+    int64_t const m_end;
+
+    int64_t m_pos;
+
+    // Copies `length` chars from `source` to `dest` in whole chunks. The chars
+    // are copied one after another as long as `length` does not exceed
+    // `dest - source`.
+    static void put_chunks (char* dest, char const* source, int64_t length);
 };
 
+inline CharArrayWriter::CharArrayWriter (
+    char* data,
+    int64_t char_cnt,
+    int64_t slack_cnt
+) :
+    m_data(data),
+    m_char_cnt(char_cnt),
+    m_end(char_cnt + slack_cnt),
+    m_pos(0)
+{
+    assert(char_cnt >= 0);
+    assert(slack_cnt >= 0);
+}
+
+inline void CharArrayWriter::put (char data) {
+    assert(m_pos < m_char_cnt);
+    m_data[m_pos++] = data;
+}
+
+inline void CharArrayWriter::put_copy (int64_t begin, int64_t length) {
+    assert(length >= 0);
+    assert(0 <= begin && (begin < m_pos || length == 0));
+    assert(m_pos + length <= m_char_cnt);
+    char* dest = m_data + m_pos;
+    char const* const source = m_data + begin;
+    m_pos += length;
+    if (m_pos + CHUNK > m_end) {
+        // The last chunk could run past the array.
+        for (int64_t i = 0; i < length; ++i)
+            dest[i] = source[i];
+        return;
+    }
+    // A copy running into its destination repeats the chars between `source`
+    // and `dest`. Each round copies all of them at once, so the distance doubles
+    // until the rest can go in one piece.
+    while (length > dest - source) {
+        int64_t const distance = dest - source;
+        put_chunks(dest, source, distance);
+        dest += distance;
+        length -= distance;
+    }
+    put_chunks(dest, source, length);
+}
+
+inline int64_t CharArrayWriter::pos () const {
+    return m_pos;
+}
+
+inline void CharArrayWriter::put_chunks (
+    char* dest,
+    char const* source,
+    int64_t length
+) {
+    // The chunk is loaded whole before it is stored, so a chunk reaching into
+    // its destination still delivers the chars that were there before. Only
+    // the chars past `length` are wrong, and they are overwritten later.
+    for (int64_t i = 0; i < length; i += CHUNK) {
+        char chunk[CHUNK];
+        memcpy(chunk, source + i, CHUNK);
+        memcpy(dest + i, chunk, CHUNK);
+    }
+}
+
+// Buffer
+// =============================================================================
+//
+// The buffer and its readers and writers backed by the default `word`.
+typedef BasicBuffer<word> Buffer;
+typedef BasicBufferView<word> BufferView;
+typedef BasicBufferBitReader<word> BufferBitReader;
+typedef BasicBufferBitWriter<word> BufferBitWriter;
+typedef BasicBufferCharReader<word> BufferCharReader;
+typedef BasicBufferCharWriter<word> BufferCharWriter;
+
 #endif // BUFFER_H
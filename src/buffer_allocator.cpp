@@ -0,0 +1,103 @@
+#include "buffer_allocator.h"
+
+// BasicBufferAllocator
+// =============================================================================
+
+template <typename Word>
+BasicBufferAllocator<Word>::~BasicBufferAllocator () {
+    /* Do nothing. */
+}
+
+// The allocator behind `BasicBufferAllocator::standard()`.
+template <typename Word>
+class NewBufferAllocator : public BasicBufferAllocator<Word> {
+public:
+    virtual Word* allocate (int64_t& word_cnt) {
+        return new Word[word_cnt];
+    }
+
+    virtual void deallocate (Word* data, int64_t word_cnt) {
+        UNUSED(word_cnt);
+        delete[] data;
+    }
+};
+
+template <typename Word>
+BasicBufferAllocator<Word>& BasicBufferAllocator<Word>::standard () {
+    static NewBufferAllocator<Word> allocator;
+    return allocator;
+}
+
+// BasicRecyclingBufferAllocator
+// =============================================================================
+
+template <typename Word>
+BasicRecyclingBufferAllocator<Word>::BasicRecyclingBufferAllocator () {
+    /* Do nothing. */
+}
+
+template <typename Word>
+Word* BasicRecyclingBufferAllocator<Word>::allocate (int64_t& word_cnt) {
+    int const size_class = ceil_log2(word_cnt);
+    word_cnt = int64_t(1) << size_class;
+    std::vector<Word*>& free = pool().free[size_class];
+    if (free.empty())
+        return new Word[word_cnt];
+    Word* const data = free.back();
+    free.pop_back();
+    return data;
+}
+
+template <typename Word>
+void BasicRecyclingBufferAllocator<Word>::deallocate (
+    Word* data,
+    int64_t word_cnt
+) {
+    int const size_class = ceil_log2(word_cnt);
+    assert(word_cnt == int64_t(1) << size_class);
+    std::vector<Word*>& free = pool().free[size_class];
+    if (free.size() < POOLED_PER_CLASS)
+        free.push_back(data);
+    else
+        delete[] data;
+}
+
+template <typename Word>
+void BasicRecyclingBufferAllocator<Word>::trim () {
+    for (std::vector<Word*>& free : pool().free) {
+        for (Word* data : free)
+            delete[] data;
+        free.clear();
+    }
+}
+
+template <typename Word>
+BasicRecyclingBufferAllocator<Word>&
+BasicRecyclingBufferAllocator<Word>::instance () {
+    static BasicRecyclingBufferAllocator allocator;
+    return allocator;
+}
+
+template <typename Word>
+typename BasicRecyclingBufferAllocator<Word>::Pool&
+BasicRecyclingBufferAllocator<Word>::pool () {
+    static thread_local Pool pool;
+    return pool;
+}
+
+template <typename Word>
+BasicRecyclingBufferAllocator<Word>::Pool::~Pool () {
+    for (std::vector<Word*>& f : free) {
+        for (Word* data : f)
+            delete[] data;
+    }
+}
+
+// Instantiations
+// =============================================================================
+
+template class BasicBufferAllocator<uint32_t>;
+template class BasicRecyclingBufferAllocator<uint32_t>;
+
+template class BasicBufferAllocator<uint64_t>;
+template class BasicRecyclingBufferAllocator<uint64_t>;
@@ -0,0 +1,81 @@
+#ifndef BUFFER_ALLOCATOR_H
+#define BUFFER_ALLOCATOR_H
+
+#include "prefix.h"
+#include <vector>
+
+// BasicBufferAllocator
+// =============================================================================
+//
+// Source of the word arrays backing a `BasicBuffer`. Every buffer holds on to
+// the allocator it has been constructed with and returns its arrays there.
+template <typename Word>
+class BasicBufferAllocator {
+public:
+    virtual ~BasicBufferAllocator ();
+
+    // Returns an array of at least `word_cnt` words. The allocator may grant
+    // more, in which case `word_cnt` is updated accordingly. The contents of
+    // the array are undefined.
+    virtual Word* allocate (int64_t& word_cnt) = 0;
+
+    // Takes back an array obtained from `allocate()`. The value `word_cnt` is
+    // the size that has been granted.
+    virtual void deallocate (Word* data, int64_t word_cnt) = 0;
+
+    // Returns the allocator that uses plain `new[]` and `delete[]`. This is
+    // what buffers use unless told otherwise.
+    static BasicBufferAllocator& standard ();
+};
+
+// BasicRecyclingBufferAllocator
+// =============================================================================
+//
+// An allocator that keeps deallocated arrays in a thread local pool and hands
+// them out again. Requests are rounded up to powers of two, so that an array
+// fits every request of its size class. Once a program reaches its steady
+// state, buffers that come and go cost no heap allocations.
+//
+// There is just one instance and it has no state of its own: arrays are always
+// taken from and returned to the pool of the calling thread. Hence buffers can
+// be freely passed between threads.
+template <typename Word>
+class BasicRecyclingBufferAllocator : public BasicBufferAllocator<Word> {
+public:
+    // Implements `BasicBufferAllocator::allocate()`.
+    virtual Word* allocate (int64_t& word_cnt);
+
+    // Implements `BasicBufferAllocator::deallocate()`.
+    virtual void deallocate (Word* data, int64_t word_cnt);
+
+    // Releases all arrays pooled by the calling thread.
+    void trim ();
+
+    // Returns the only instance.
+    static BasicRecyclingBufferAllocator& instance ();
+
+private:
+    // Maximum number of arrays kept in each size class.
+    static int const POOLED_PER_CLASS = 8;
+
+    // Free arrays of the calling thread, indexed by the base two logarithm of
+    // their size.
+    struct Pool {
+        std::vector<Word*> free[64];
+
+        ~Pool ();
+    };
+
+    static Pool& pool ();
+
+    BasicRecyclingBufferAllocator ();
+};
+
+// Buffer allocators
+// =============================================================================
+//
+// The allocators for the default `word`.
+typedef BasicBufferAllocator<word> BufferAllocator;
+typedef BasicRecyclingBufferAllocator<word> RecyclingBufferAllocator;
+
+#endif // BUFFER_ALLOCATOR_H
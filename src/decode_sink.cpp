@@ -0,0 +1,57 @@
+#include "decode_sink.h"
+
+// DecodeSink
+// =============================================================================
+
+DecodeSink::~DecodeSink () {
+    /* Do nothing. */
+}
+
+// BufferDecodeSink
+// =============================================================================
+
+BufferDecodeSink::BufferDecodeSink (Buffer& buffer) :
+    m_writer(buffer)
+{
+    /* Do nothing. */
+}
+
+void BufferDecodeSink::put (char const* data, int64_t char_cnt) {
+    m_writer.put(data, char_cnt);
+}
+
+// StreamDecodeSink
+// =============================================================================
+
+StreamDecodeSink::StreamDecodeSink (std::ostream& ostr) :
+    m_ostr(ostr)
+{
+    /* Do nothing. */
+}
+
+void StreamDecodeSink::put (char const* data, int64_t char_cnt) {
+    m_ostr.write(data, char_cnt);
+}
+
+// SinkWriter
+// =============================================================================
+
+int64_t const SinkWriter::CHUNK_CNT;
+
+SinkWriter::SinkWriter (DecodeSink& sink, int64_t chunk_cnt) :
+    m_sink(sink),
+    m_chunk(chunk_cnt),
+    m_size(0)
+{
+    assert(chunk_cnt > 0);
+}
+
+SinkWriter::~SinkWriter () {
+    flush();
+}
+
+void SinkWriter::flush () {
+    if (m_size != 0)
+        m_sink.put(m_chunk.data(), m_size);
+    m_size = 0;
+}
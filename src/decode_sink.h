@@ -0,0 +1,109 @@
+#ifndef DECODE_SINK_H
+#define DECODE_SINK_H
+
+#include "prefix.h"
+#include <vector>
+
+#include "buffer.h"
+
+// DecodeSink
+// =============================================================================
+//
+// Destination of the output of `Lz::decode(BufferView const&, DecodeSink&)`.
+// The decoded text is passed in chunks, which needn't be retained, so that the
+// decoded data never has to be kept in memory as a whole.
+class DecodeSink {
+public:
+    virtual ~DecodeSink ();
+
+    // Consumes `char_cnt` chars starting at `data`. The memory is valid only
+    // for the duration of the call.
+    virtual void put (char const* data, int64_t char_cnt) = 0;
+};
+
+// BufferDecodeSink
+// =============================================================================
+//
+// A sink appending everything to a buffer.
+class BufferDecodeSink final : public DecodeSink {
+public:
+    // Constructs a sink that appends to `buffer`. The buffer has to outlive
+    // the sink.
+    explicit BufferDecodeSink (Buffer& buffer);
+
+    // Implements `DecodeSink::put()`.
+    virtual void put (char const* data, int64_t char_cnt);
+
+private:
+    BufferCharWriter m_writer;
+};
+
+// StreamDecodeSink
+// =============================================================================
+//
+// A sink writing to a `std::ostream`.
+class StreamDecodeSink final : public DecodeSink {
+public:
+    // Constructs a sink that writes to `ostr`, which has to outlive the sink.
+    explicit StreamDecodeSink (std::ostream& ostr);
+
+    // Implements `DecodeSink::put()`.
+    virtual void put (char const* data, int64_t char_cnt);
+
+private:
+    std::ostream& m_ostr;
+};
+
+// SinkWriter
+// =============================================================================
+//
+// Collects decoded text into chunks of fixed size before passing them to
+// a `DecodeSink`. Codewords are spelled directly into the chunk.
+class SinkWriter {
+public:
+    // Default number of chars in a chunk.
+    static int64_t const CHUNK_CNT = 1 << 16;
+
+    // Constructs a writer passing chunks of `chunk_cnt` chars to `sink`.
+    explicit SinkWriter (DecodeSink& sink, int64_t chunk_cnt = CHUNK_CNT);
+
+    // Flushes what is left.
+    ~SinkWriter ();
+
+    // Appends `char_cnt` chars to the output and returns their address, so
+    // that the caller can fill them in. The address is valid until the next
+    // call. Requests longer than a chunk make the chunk grow.
+    char* append (int64_t char_cnt);
+
+    // Appends a single char.
+    void put (char a);
+
+    // Passes the collected chars to the sink.
+    void flush ();
+
+private:
+    DecodeSink& m_sink;
+
+    // The chunk being collected.
+    std::vector<char> m_chunk;
+
+    // Number of chars collected in `m_chunk`.
+    int64_t m_size;
+};
+
+inline char* SinkWriter::append (int64_t char_cnt) {
+    if (m_size + char_cnt > int64_t(m_chunk.size())) {
+        flush();
+        if (char_cnt > int64_t(m_chunk.size()))
+            m_chunk.resize(char_cnt);
+    }
+    char* const result = m_chunk.data() + m_size;
+    m_size += char_cnt;
+    return result;
+}
+
+inline void SinkWriter::put (char a) {
+    *append(1) = a;
+}
+
+#endif // DECODE_SINK_H
@@ -61,14 +61,14 @@ inline int Dict::limit () const {
 // TODO
 struct Match {
     int codeword_no;
-    int length;
+    int64_t length;
     char extending_char;
 
     // Constructs a non-maximal match
     Match ();
 
     // Constructs a maximal match.
-    Match (int codeword_no, int length, char extending_char);
+    Match (int codeword_no, int64_t length, char extending_char);
 
     bool is_maximal () const;
 
@@ -82,7 +82,7 @@ inline Match::Match () :
     /* Do nothing */
 }
 
-inline Match::Match (int codeword_no, int length, char extending_char) :
+inline Match::Match (int codeword_no, int64_t length, char extending_char) :
     codeword_no(codeword_no),
     length(length),
     extending_char(extending_char)
@@ -105,6 +105,37 @@ inline bool Match::operator == (Match const& match) const {
         );
 }
 
+// EncodeStats
+// =============================================================================
+//
+// Counts of what has been encoded with a dictionary since it was last reset.
+// Encoders keep them in the dictionary, so that they survive between the calls
+// of the factorization loop, e.g., in `StreamEncoder`.
+struct EncodeStats {
+    // Input chars consumed.
+    int64_t char_cnt;
+
+    // Bits of codewords written.
+    int64_t bit_cnt;
+
+    // The counts at the last time the compression ratio was checked. The bit
+    // count stays `0` until the dictionary is full, as only then is the ratio
+    // worth comparing to.
+    int64_t checked_char_cnt;
+    int64_t checked_bit_cnt;
+
+    EncodeStats ();
+};
+
+inline EncodeStats::EncodeStats () :
+    char_cnt(0),
+    bit_cnt(0),
+    checked_char_cnt(0),
+    checked_bit_cnt(0)
+{
+    /* Do nothing. */
+}
+
 // EncodeDict
 // =============================================================================
 //
@@ -116,7 +147,7 @@ inline bool Match::operator == (Match const& match) const {
 class EncodeDict {
 public:
     // TODO doc
-    EncodeDict (Buffer const& input);
+    EncodeDict (BufferView const& input);
 
     // Advances the internal state of the automaton, trying to match the
     // currently matched codeword extended by another letter, i.e., `a`.
@@ -138,46 +169,106 @@ public:
     // allows different behaviour depending on encoding method.
     virtual Match fail_char () = 0;
 
+    // Finds the longest match starting at the current position in a single
+    // forward pass over the input and adds the new codeword like `try_char()`
+    // does. The dictionary is left right past the match, at its extending
+    // char, without the need to put anything back.
+    //
+    // If the input ends before the match is known to be maximal, it depends on
+    // `last`. If set, the dictionary behaves like `fail_char()` and the match
+    // may take up all the remaining input. Otherwise the match may go on in
+    // the input to come, so a non maximal match is returned and the position
+    // is left unchanged.
+    virtual Match next_match (bool last) = 0;
+
     // TODO doc
-    void put_back (int char_cnt);
+    void put_back (int64_t char_cnt);
+
+    // Skips `char_cnt` chars of the input.
+    void skip (int64_t char_cnt);
 
     bool eob () const;
 
+    // Returns the index of the next char to be read from the input.
+    int64_t next_pos () const;
+
+    // Moves the dictionary over to `input`, positioned at its char `pos`. Used
+    // by `StreamEncoder` whenever its input window grows or gets compacted.
+    // Dictionaries that keep positions within the input have to hide this
+    // method and follow along.
+    void attach (BufferView const& input, int64_t pos);
+
+    // Returns the statistics kept by the encoder.
+    EncodeStats& stats ();
+
 protected:
     // TODO doc
     char get_char ();
 
     // Returns the index of the last char read from the buffer. Before anything
     // is read, the result is `-1`.
-    int pos () const;
+    int64_t pos () const;
+
+    // Returns the part of the input that hasn't been read yet.
+    BufferCharSlice lookahead () const;
 
 private:
+    // The input.
+    BufferView m_input;
+
     // TODO doc
     BufferCharReader m_reader;
+
+    // The statistics kept by the encoder.
+    EncodeStats m_stats;
 };
 
-inline EncodeDict::EncodeDict (Buffer const& input) :
+inline EncodeDict::EncodeDict (BufferView const& input) :
+    m_input(input),
     m_reader(input)
 {
     /* Do nothing. */
 }
 
-inline void EncodeDict::put_back (int char_cnt) {
+inline void EncodeDict::put_back (int64_t char_cnt) {
     m_reader.put_back(char_cnt);
 }
 
+inline void EncodeDict::skip (int64_t char_cnt) {
+    m_reader.skip(char_cnt);
+}
+
 inline bool EncodeDict::eob () const {
     return m_reader.eob();
 }
 
+inline int64_t EncodeDict::next_pos () const {
+    return m_reader.pos() + 1;
+}
+
+inline void EncodeDict::attach (BufferView const& input, int64_t pos) {
+    m_input = input;
+    m_reader = BufferCharReader(input);
+    m_reader.skip(pos);
+}
+
+inline EncodeStats& EncodeDict::stats () {
+    return m_stats;
+}
+
 inline char EncodeDict::get_char () {
     return m_reader.get();
 }
 
-inline int EncodeDict::pos () const {
+inline int64_t EncodeDict::pos () const {
     return m_reader.pos();
 }
 
+inline BufferCharSlice EncodeDict::lookahead () const {
+    int64_t const begin = next_pos();
+    return BufferCharSlice(m_input, begin, m_input.size() / CHAR_BITS - begin);
+}
+
 // Codeword
 // =============================================================================
 //
@@ -185,17 +276,17 @@ inline int EncodeDict::pos () const {
 // Such subsequence is determined by its starting index `begin` and its
 // `length`.
 struct Codeword {
-    int begin;
-    int length;
+    int64_t begin;
+    int64_t length;
 
     // Creates a new codeword with given starting index and length.
-    Codeword (int begin, int length);
+    Codeword (int64_t begin, int64_t length);
 
     // Returns `true` if `cw` is equal to this codeword.
     inline bool operator == (Codeword const& cw) const;
 };
 
-inline Codeword::Codeword (int begin, int length) :
+inline Codeword::Codeword (int64_t begin, int64_t length) :
     begin(begin),
     length(length)
 {
@@ -216,7 +307,7 @@ class DecodeDict {
     // and is a one-letter extension of the existing codeword `i`. Unless the
     // limit has been reached the codewords should receive the consecutive
     // integers as indices, starting from 1.
-    virtual void add_extension (int i, int begin) = 0;
+    virtual void add_extension (int i, int64_t begin) = 0;
 
     // Returns the `i`th codeword.
     virtual Codeword codeword (int i) const = 0;
@@ -0,0 +1,176 @@
+#ifndef EDGE_TABLE_H
+#define EDGE_TABLE_H
+
+#include "prefix.h"
+#include <vector>
+
+// EdgeTable
+// =============================================================================
+//
+// A hash table of the edges of a codeword trie. An edge is keyed by its parent
+// and the char it is labelled with, packed together into an unsigned integer
+// of type `Key`, and carries a `Value`.
+//
+// The table uses open addressing with linear probing over a power of two
+// array. Removed edges don't leave tombstones behind, the following slots are
+// shifted back instead, so that the probe sequences stay short no matter how
+// many edges come and go. The table doubles whenever it gets more than half
+// full; a dictionary with a known limit can size it so that it never does.
+template <typename Key, typename Value>
+class EdgeTable {
+public:
+    // The key of free slots. No edge has it.
+    static Key const NO_KEY = ~Key(0);
+
+    struct Slot {
+        Key key;
+        Value value;
+    };
+
+    // Constructs an empty table of `2^slot_bits` slots.
+    explicit EdgeTable (int slot_bits);
+
+    // Returns the key of the edge from `parent` labelled `a`. The parent has
+    // to fit in `Key` along with the label, and the key mustn't be `NO_KEY`.
+    static Key key (int parent, char a);
+
+    // Returns the slot holding `key`, or the free slot where it belongs.
+    int find (Key key) const;
+
+    Slot& operator [] (int s);
+
+    Slot const& operator [] (int s) const;
+
+    // Puts the edge `key` carrying `value` into slot `s`, which has to be the
+    // free slot `find(key)` returned. The table may grow, so the slots found
+    // before are invalidated.
+    void insert (int s, Key key, Value const& value);
+
+    // Frees slot `s`. The following slots are moved back into place, so the
+    // slots found before are invalidated.
+    void remove (int s);
+
+    // Frees all slots. The table keeps its size.
+    void clear ();
+
+private:
+    static int const KEY_BITS = 8 * sizeof(Key);
+
+    std::vector<Slot> m_slots;
+
+    // The number of bits in `m_slots.size()`, which is a power of two.
+    int m_slot_bits;
+
+    // Number of used slots.
+    int m_slot_cnt;
+
+    // Returns the slot `key` would take in an empty table.
+    int home (Key key) const;
+
+    // Doubles the table.
+    void grow ();
+};
+
+template <typename Key, typename Value>
+Key const EdgeTable<Key, Value>::NO_KEY;
+
+template <typename Key, typename Value>
+EdgeTable<Key, Value>::EdgeTable (int slot_bits) :
+    m_slots(size_t(1) << slot_bits, Slot{NO_KEY, Value()}),
+    m_slot_bits(slot_bits),
+    m_slot_cnt(0)
+{
+    // The hash takes the top bits of a key sized product.
+    assert(0 < slot_bits && slot_bits < KEY_BITS);
+}
+
+template <typename Key, typename Value>
+inline Key EdgeTable<Key, Value>::key (int parent, char a) {
+    assert(parent >= 0);
+    Key const result = Key(parent) << CHAR_BITS | uint8_t(a);
+    assert(result >> CHAR_BITS == Key(parent) && result != NO_KEY);
+    return result;
+}
+
+template <typename Key, typename Value>
+inline int EdgeTable<Key, Value>::find (Key key) const {
+    int const mask = m_slots.size() - 1;
+    int s = home(key);
+    while (m_slots[s].key != key && m_slots[s].key != NO_KEY)
+        s = (s + 1) & mask;
+    return s;
+}
+
+template <typename Key, typename Value>
+inline typename EdgeTable<Key, Value>::Slot&
+EdgeTable<Key, Value>::operator [] (int s) {
+    return m_slots[s];
+}
+
+template <typename Key, typename Value>
+inline typename EdgeTable<Key, Value>::Slot const&
+EdgeTable<Key, Value>::operator [] (int s) const {
+    return m_slots[s];
+}
+
+template <typename Key, typename Value>
+inline void EdgeTable<Key, Value>::insert (
+    int s,
+    Key key,
+    Value const& value
+) {
+    assert(m_slots[s].key == NO_KEY);
+    assert(s == find(key));
+    m_slots[s] = Slot{key, value};
+    if (2 * ++m_slot_cnt > int64_t(m_slots.size()))
+        grow();
+}
+
+template <typename Key, typename Value>
+void EdgeTable<Key, Value>::remove (int s) {
+    assert(m_slots[s].key != NO_KEY);
+    int const mask = m_slots.size() - 1;
+    // A slot can move back to the freed one unless its home lies cyclically
+    // between the two.
+    int t = s;
+    while (true) {
+        t = (t + 1) & mask;
+        Slot const& slot = m_slots[t];
+        if (slot.key == NO_KEY)
+            break;
+        int const h = home(slot.key);
+        if (((t - h) & mask) >= ((t - s) & mask)) {
+            m_slots[s] = slot;
+            s = t;
+        }
+    }
+    m_slots[s].key = NO_KEY;
+    --m_slot_cnt;
+}
+
+template <typename Key, typename Value>
+void EdgeTable<Key, Value>::clear () {
+    std::fill(m_slots.begin(), m_slots.end(), Slot{NO_KEY, Value()});
+    m_slot_cnt = 0;
+}
+
+template <typename Key, typename Value>
+inline int EdgeTable<Key, Value>::home (Key key) const {
+    // Fibonacci hashing, the high bits of the product are the best mixed. The
+    // multiplier is `2^KEY_BITS` divided by the golden ratio.
+    Key const multiplier = 0x9E3779B97F4A7C15ull >> (64 - KEY_BITS);
+    return Key(key * multiplier) >> (KEY_BITS - m_slot_bits);
+}
+
+template <typename Key, typename Value>
+void EdgeTable<Key, Value>::grow () {
+    std::vector<Slot> slots(2 * m_slots.size(), Slot{NO_KEY, Value()});
+    slots.swap(m_slots);
+    ++m_slot_bits;
+    for (Slot const& slot : slots) {
+        if (slot.key != NO_KEY)
+            m_slots[find(slot.key)] = slot;
+    }
+}
+
+#endif // EDGE_TABLE_H
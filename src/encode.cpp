@@ -7,17 +7,25 @@ using std::ofstream;
 #include "huffman.h"
 #include "lz78.h"
 #include "lzw.h"
+#include "mapped_file.h"
 #include "mra_dict.h"
 #include "smru_dict.h"
 #include "wmru_dict.h"
 
 string exec_name;
 
+// Prints the number of codewords in `output`, which `lz` encoded.
+void print_codeword_cnt (Lz const& lz, BufferView const& output) {
+    cout << "\n     codewords: " << (lz.variable_width() ? "at least " : "")
+         << lz.min_codeword_cnt(output);
+}
+
 int fail () {
     cout << "usage:\n\t" << exec_name << " "
-         << "e [lz78|lzw] [smru|wmru|mra] dictsize filename"
+         << "e [lz78|lzw|lz78v|lzwv] [smru|wmru|mra] dictsize filename"
          << "\n\t" << exec_name << " "
          << "d filename"
+         << "\nthe 'v' schemes use variable width codeword numbers"
          << "\nexample:\n\t" << exec_name << " "
          << "e lzw wmru 500 hello.txt"
          << "\n\t" << exec_name << " "
@@ -47,12 +55,20 @@ Lz const* get_encoder (
     string const& s_limit
 ) {
     Scheme scheme;
+    bool variable_width = false;
     if (s_scheme == "lz78") {
         scheme = LZ78;
     } else if (s_scheme == "lzw") {
         scheme = LZW;
+    } else if (s_scheme == "lz78v") {
+        scheme = LZ78;
+        variable_width = true;
+    } else if (s_scheme == "lzwv") {
+        scheme = LZW;
+        variable_width = true;
     } else {
-        cout << "Expected 'lz78' or 'lzw', got '" << s_scheme << "'\n";
+        cout << "Expected 'lz78', 'lzw', 'lz78v' or 'lzwv', got '"
+             << s_scheme << "'\n";
         return nullptr;
     }
 
@@ -78,42 +94,47 @@ Lz const* get_encoder (
     switch (scheme) {
         case LZ78:
             switch (dict) {
-                case SMRU: return new Lz78<Smru>(limit); break;
-                case WMRU: return new Lz78<Wmru>(limit); break;
-                case  MRA: return new Lz78<Mra>(limit); break;
+                case SMRU: return new Lz78<Smru>(limit, variable_width); break;
+                case WMRU: return new Lz78<Wmru>(limit, variable_width); break;
+                case  MRA: return new Lz78<Mra>(limit, variable_width); break;
             }
             break;
         case LZW:
             switch (dict) {
-                case SMRU: return new Lzw<Smru>(limit); break;
-                case WMRU: return new Lzw<Wmru>(limit); break;
-                case  MRA: return new Lzw<Mra>(limit); break;
+                case SMRU: return new Lzw<Smru>(limit, variable_width); break;
+                case WMRU: return new Lzw<Wmru>(limit, variable_width); break;
+                case  MRA: return new Lzw<Mra>(limit, variable_width); break;
             }
             break;
     }
 }
 
 int encode (int argc, char** argv) {
-    if (argc < 5)
+    if (argc < 6)
         return fail();
 
     Lz const* encoder = get_encoder(argv[2], argv[3], argv[4]);
     if (encoder == nullptr)
         return fail();
 
+    // Regular files are mapped into memory and encoded in place. Anything else
+    // (pipes, devices) is read into a buffer.
     string s_infile = argv[5];
-    ifstream infile(s_infile.c_str());
-    if (!infile) {
-        cout << "Cannot open " << s_infile << "\n";
-        delete encoder;
-        return fail();
+    MappedFile mapped_infile(s_infile);
+    Buffer read_input;
+    if (!mapped_infile.is_open()) {
+        ifstream infile(s_infile.c_str());
+        if (!infile) {
+            cout << "Cannot open " << s_infile << "\n";
+            delete encoder;
+            return fail();
+        }
+        BufferCharWriter writer(read_input);
+        writer.put_stream(infile);
+        infile.close();
     }
-    Buffer input;
-    BufferCharWriter writer(input);
-    char a;
-    while (infile.get(a))
-        writer.put(a);
-    infile.close();
+    Buffer const& input =
+        mapped_infile.is_open() ? mapped_infile.buffer() : read_input;
 
     cout << "Original file: " << double(input.size()) / 8000.0 << "kB\n";
 
@@ -123,9 +144,9 @@ int encode (int argc, char** argv) {
     auto t1 = system_clock::now();
     cout << "done"
          << "\n    time taken: " << duration_cast<milliseconds>(t1 - t0)
-         << "\n          size: " << double(lz_input.size()) / 8000.0 << "kB"
-         << "\n     codewords: " << lz_input.size() / encoder->codeword_bits()
-         << endl;
+         << "\n          size: " << double(lz_input.size()) / 8000.0 << "kB";
+    print_codeword_cnt(*encoder, lz_input);
+    cout << endl;
     delete encoder;
 
     cout << "Encoding with Huffman ... " << flush;
@@ -145,14 +166,19 @@ int encode (int argc, char** argv) {
         cout << "Cannot create " << s_outfile << "\n";
         return fail();
     }
-    BufferCharReader reader(huffman_lz_input);
-    word last_word = reader.last_word();
-    int const char_cnt = (huffman_lz_input.size() / WORD_BITS) * WORD_CHARS;
-    int remaining_bits = huffman_lz_input.size() - CHAR_BITS * char_cnt;
+    // The bits are saved eight at a time, in order, so that the file doesn't
+    // depend on the word width. The bits past the last whole char are stored
+    // in the header.
+    int64_t const char_cnt = huffman_lz_input.size() / CHAR_BITS;
+    int const tail_cnt = huffman_lz_input.size() - CHAR_BITS * char_cnt;
+    int const tail = BufferBitReader(
+        BufferView(huffman_lz_input).slice(CHAR_BITS * char_cnt, tail_cnt)
+    ).get(tail_cnt);
     outfile << argv[2] << " " << argv[3] << " " << argv[4] << " "
-            << last_word << " " << remaining_bits << " ";
-    for (int i = 0; i < char_cnt; ++i)
-        outfile.put(reader.get());
+            << tail << " " << tail_cnt << " ";
+    BufferBitReader reader(huffman_lz_input);
+    for (int64_t i = 0; i < char_cnt; ++i)
+        outfile.put(reader.get(CHAR_BITS));
     cout << char_cnt << " ";
     outfile.close();
     cout << "done" << endl;
@@ -174,23 +200,25 @@ int decode (int argc, char** argv) {
     string s_scheme;
     string s_dict;
     string s_limit;
-    word last_word;
-    int remaining_bits;
-    outfile >> s_scheme >> s_dict >> s_limit >> last_word >> remaining_bits;
+    int tail;
+    int tail_cnt;
+    outfile >> s_scheme >> s_dict >> s_limit >> tail >> tail_cnt;
 
     Lz const* encoder = get_encoder(s_scheme, s_dict, s_limit);
     if (encoder == nullptr)
         return fail();
 
+    // The chars hold the bits in order, see `encode()`.
     Buffer output;
-    BufferCharWriter writer(output);
-    char a;
-    outfile.get(a);
-    assert(a == ' ');
-    while (outfile.get(a)) {
-        writer.put(a);
+    {
+        BufferBitWriter writer(output);
+        char a;
+        outfile.get(a);
+        assert(a == ' ');
+        while (outfile.get(a))
+            writer.put(uint8_t(a), CHAR_BITS);
+        writer.put(tail, tail_cnt);
     }
-    writer.put_last_word(last_word, remaining_bits);
 
     cout << "Compressed file: " << double(output.size()) / 8000.0 << "kB"
          << "\n encoded using: " << s_scheme << " " << s_dict
@@ -207,31 +235,27 @@ int decode (int argc, char** argv) {
                                  << "kB"
          << endl;
 
-    cout << "Decoding with LZ ... " << flush;
-    auto t2 = system_clock::now();
-    Buffer lz_huffman_output = encoder->decode(huffman_output);
-    auto t3 = system_clock::now();
-    cout << "done"
-         << "\n    time taken: " << duration_cast<milliseconds>(t3 - t2)
-         << "\n          size: " << double(lz_huffman_output.size()) / 8000.0
-                                 << "kB"
-         << "\n     codewords: " << huffman_output.size()
-                                  / encoder->codeword_bits()
-         << endl;
-    delete encoder;
-
+    // The decoded data goes straight to the file, so it is never held in
+    // memory as a whole.
     string s_infile = s_outfile + ".zl";
-    cout << "Saving to " << s_infile << " ... " << flush;
     ofstream infile(s_infile.c_str());
     if (!infile) {
         cout << "Cannot create " << s_infile << "\n";
         return fail();
     }
-    BufferCharReader reader(lz_huffman_output);
-    while (!reader.eob())
-        infile.put(reader.get());
+    cout << "Decoding with LZ to " << s_infile << " ... " << flush;
+    auto t2 = system_clock::now();
+    StreamDecodeSink sink(infile);
+    encoder->decode(huffman_output, sink);
+    double const size = double(infile.tellp()) / 1000.0;
     infile.close();
-    cout << "done" << endl;
+    auto t3 = system_clock::now();
+    cout << "done"
+         << "\n    time taken: " << duration_cast<milliseconds>(t3 - t2)
+         << "\n          size: " << size << "kB";
+    print_codeword_cnt(*encoder, huffman_output);
+    cout << endl;
+    delete encoder;
 
     return 0;
 }
@@ -0,0 +1,330 @@
+#ifndef HASH_DICT_H
+#define HASH_DICT_H
+
+#include "prefix.h"
+#include <vector>
+
+#include "dict.h"
+#include "edge_table.h"
+#include "mra_dict.h"
+#include "pool_dict.h"
+#include "smru_dict.h"
+#include "wmru_dict.h"
+
+// HashEncodeDict
+// =============================================================================
+//
+// An encode dictionary that keeps the trie of its codewords in a flat hash
+// table rather than in linked nodes, an `EdgeTable` keyed by the parent node
+// and the char leading to the child. Every edge carries the codeword number of
+// the child too, so that matching touches nothing but the table.
+//
+// The codewords are numbered by `Pool`, any of the pools can be used. Just
+// like in `PoolDictTree`, a discarded codeword keeps its node for as long as
+// some other codeword extends it, so the nodes are reference counted and
+// identified by their own indices rather than by codeword numbers.
+//
+// The codewords, and therefore the encodings, are the same as with
+// `PoolEncodeDict<Pool>`. The dictionary doesn't refer to the input, so it is
+// ready for `StreamEncoder` and `PresetDict` as it is.
+template <typename Pool>
+class HashEncodeDict final : public PoolDict<Pool>, public EncodeDict {
+public:
+    HashEncodeDict (
+        BufferView const& input,
+        int limit,
+        bool single_char_codewords
+    );
+
+    // Implements `EncodeDict::try_char()`.
+    virtual Match try_char ();
+
+    // Implements `EncodeDict::fail_char()`.
+    virtual Match fail_char ();
+
+    // Implements `EncodeDict::next_match()`.
+    virtual Match next_match (bool last);
+
+    // Leaves `text` empty, like `SmruEncodeDict::compact()`.
+    void compact (Buffer& text) const;
+
+    // Does nothing, like `SmruEncodeDict::detach()`.
+    void detach ();
+
+    // Drops all codewords but the permanent ones, as if the dictionary were
+    // constructed anew. The position within the input is kept.
+    void reset ();
+
+private:
+    // What an edge of the trie leads to.
+    struct Edge {
+        int child;
+        // The codeword number of `child`, or `-1` if it has been discarded.
+        int codeword_no;
+    };
+
+    typedef EdgeTable<uint64_t, Edge> Edges;
+
+    struct Node {
+        int parent;
+        // Number of child nodes, plus one if the node is a codeword.
+        int ref_cnt;
+        char a;
+    };
+
+    // The edges of the trie.
+    Edges m_edges;
+
+    // All nodes, including the free ones. Node 0 is the root, i.e., the empty
+    // codeword.
+    std::vector<Node> m_nodes;
+
+    // Indices of free elements of `m_nodes`.
+    std::vector<int> m_free_nodes;
+
+    // An array mapping codeword numbers to nodes. Unused numbers map to `-1`.
+    std::vector<int> m_codeword_nodes;
+
+    // State of `try_char()`, the node reached so far, its codeword number and
+    // its depth.
+    int m_node;
+    int m_codeword_no;
+    int64_t m_depth;
+
+    // The longest match passed by `try_char()` so far.
+    Match m_match;
+
+    // Returns the slot holding the edge from `parent` labelled `a`, or the
+    // free slot where it belongs.
+    int find (int parent, char a) const;
+
+    // Adds the extension of codeword `i` by `a`, unless the pool rejects it.
+    void extend (int i, char a);
+
+    // Creates a node extending `parent` by `a`, whose slot is `s`, and
+    // returns it.
+    int new_node (int parent, char a, int s);
+
+    // Drops a reference to node `k`, freeing it and possibly its ancestors.
+    void release (int k);
+
+    // Makes `try_char()` start at the root.
+    void reset_search ();
+
+    // Adds the single char codewords, if there are any.
+    void add_single_chars ();
+};
+
+template <typename Pool>
+HashEncodeDict<Pool>::HashEncodeDict (
+    BufferView const& input,
+    int limit,
+    bool single_char_codewords
+) :
+    PoolDict<Pool>(limit, single_char_codewords),
+    EncodeDict(input),
+    // Sized for the codewords, the table is at most half full.
+    m_edges(ceil_log2(2 * int64_t(limit) + 2)),
+    m_codeword_nodes(limit + 1, -1)
+{
+    m_nodes.reserve(limit + 1);
+    reset();
+}
+
+template <typename Pool>
+void HashEncodeDict<Pool>::reset () {
+    PoolDict<Pool>::reset();
+    m_edges.clear();
+    m_nodes.assign(1, Node{0, 1, '\0'});
+    m_free_nodes.clear();
+    std::fill(m_codeword_nodes.begin(), m_codeword_nodes.end(), -1);
+    m_codeword_nodes[0] = 0;
+    reset_search();
+    add_single_chars();
+}
+
+template <typename Pool>
+inline Match HashEncodeDict<Pool>::try_char () {
+    char a = this->get_char();
+    if (m_codeword_no != -1)
+        m_match = Match(m_codeword_no, m_depth, a);
+    typename Edges::Slot const& slot = m_edges[find(m_node, a)];
+    if (slot.key != Edges::NO_KEY) {
+        m_node = slot.value.child;
+        m_codeword_no = slot.value.codeword_no;
+        ++m_depth;
+        return Match();
+    }
+    extend(m_match.codeword_no, m_match.extending_char);
+    reset_search();
+    return m_match;
+}
+
+template <typename Pool>
+Match HashEncodeDict<Pool>::fail_char () {
+    assert(m_node != 0);
+    if (m_codeword_no != -1)
+        m_match = Match(m_codeword_no, m_depth, '\0');
+    else
+        extend(m_match.codeword_no, m_match.extending_char);
+    reset_search();
+    return m_match;
+}
+
+template <typename Pool>
+Match HashEncodeDict<Pool>::next_match (bool last) {
+    assert(m_node == 0);
+    BufferCharSlice const text = this->lookahead();
+
+    int node = 0;
+    int64_t depth = 0;
+    // The deepest codeword passed so far is the longest match.
+    int match = 0;
+    int64_t match_length = 0;
+    // The codeword number of `node`.
+    int codeword_no = 0;
+    while (true) {
+        if (codeword_no != -1) {
+            match = codeword_no;
+            match_length = depth;
+        }
+        if (depth == text.length())
+            break;
+        typename Edges::Slot const& slot = m_edges[find(node, text[depth])];
+        if (slot.key == Edges::NO_KEY)
+            break;
+        node = slot.value.child;
+        codeword_no = slot.value.codeword_no;
+        ++depth;
+    }
+
+    bool const ended = depth == text.length();
+    if (ended && !last)
+        return Match();
+
+    this->skip(match_length);
+    if (ended && match_length == depth) {
+        // The rest of the input is a codeword. Like in `fail_char()`, there is
+        // nothing to extend it with.
+        return Match(match, match_length, '\0');
+    }
+    char const a = text[match_length];
+    extend(match, a);
+    return Match(match, match_length, a);
+}
+
+template <typename Pool>
+inline void HashEncodeDict<Pool>::compact (Buffer& text) const {
+    UNUSED(text);
+}
+
+template <typename Pool>
+inline void HashEncodeDict<Pool>::detach () {
+    /* Do nothing. */
+}
+
+template <typename Pool>
+inline int HashEncodeDict<Pool>::find (int parent, char a) const {
+    return m_edges.find(Edges::key(parent, a));
+}
+
+template <typename Pool>
+void HashEncodeDict<Pool>::extend (int i, char a) {
+    assert(0 <= i && i < m_codeword_nodes.size());
+    assert(m_codeword_nodes[i] != -1);
+    int const parent = m_codeword_nodes[i];
+    int const j = this->match(i);
+    if (j == 0)
+        return;
+    int s = find(parent, a);
+    int k;
+    if (m_edges[s].key == Edges::NO_KEY) {
+        k = new_node(parent, a, s);
+    } else {
+        // The extension is there already as a prefix of other codewords.
+        assert(m_edges[s].value.codeword_no == -1);
+        k = m_edges[s].value.child;
+        ++m_nodes[k].ref_cnt;
+    }
+    // The new node refers to `parent` before the previous codeword `j` is
+    // released, so that `parent` survives even if it's that codeword.
+    int const old = m_codeword_nodes[j];
+    if (old != -1) {
+        Node const& node = m_nodes[old];
+        m_edges[find(node.parent, node.a)].value.codeword_no = -1;
+        release(old);
+    }
+    // Releasing may have moved the slots around.
+    m_edges[find(parent, a)].value.codeword_no = j;
+    m_codeword_nodes[j] = k;
+}
+
+template <typename Pool>
+int HashEncodeDict<Pool>::new_node (int parent, char a, int s) {
+    Node const node{parent, 1, a};
+    ++m_nodes[parent].ref_cnt;
+    int k;
+    if (m_free_nodes.empty()) {
+        m_nodes.push_back(node);
+        k = m_nodes.size() - 1;
+    } else {
+        k = m_free_nodes.back();
+        m_free_nodes.pop_back();
+        m_nodes[k] = node;
+    }
+    m_edges.insert(s, Edges::key(parent, a), Edge{k, -1});
+    return k;
+}
+
+template <typename Pool>
+void HashEncodeDict<Pool>::release (int k) {
+    while (--m_nodes[k].ref_cnt == 0) {
+        assert(k != 0);
+        Node const& node = m_nodes[k];
+        m_edges.remove(find(node.parent, node.a));
+        m_free_nodes.push_back(k);
+        k = node.parent;
+    }
+}
+
+template <typename Pool>
+inline void HashEncodeDict<Pool>::reset_search () {
+    m_node = 0;
+    m_codeword_no = 0;
+    m_depth = 0;
+}
+
+template <typename Pool>
+void HashEncodeDict<Pool>::add_single_chars () {
+    for (int a = 0; a < this->fixed_cnt(); ++a) {
+        int const k = new_node(0, a, find(0, a));
+        m_edges[find(0, a)].value.codeword_no = a + 1;
+        m_codeword_nodes[a + 1] = k;
+    }
+}
+
+// HashSmru, HashWmru, HashMra
+// =============================================================================
+//
+// The hash table counterparts of `Smru`, `Wmru` and `Mra`. They produce the
+// same encodings, so the decode dictionaries are shared.
+
+struct HashSmru {
+    typedef HashEncodeDict<SmruPool> EncodeDict;
+    typedef PoolDecodeDict<SmruPool> DecodeDict;
+    typedef PoolLinkDecodeDict<SmruPool> LinkDecodeDict;
+};
+
+struct HashWmru {
+    typedef HashEncodeDict<WmruPool> EncodeDict;
+    typedef PoolDecodeDict<WmruPool> DecodeDict;
+    typedef PoolLinkDecodeDict<WmruPool> LinkDecodeDict;
+};
+
+struct HashMra {
+    typedef HashEncodeDict<MraPool> EncodeDict;
+    typedef PoolDecodeDict<MraPool> DecodeDict;
+    typedef PoolLinkDecodeDict<MraPool> LinkDecodeDict;
+};
+
+#endif // HASH_DICT_H
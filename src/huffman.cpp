@@ -1,33 +1,55 @@
 #include "huffman.h"
+#include <algorithm>
 #include <queue>
 
-// Huffman
+// BasicHuffman
 // =============================================================================
 
-Buffer Huffman::encode (Buffer const& input) {
+template <typename Word>
+BasicBuffer<Word> BasicHuffman<Word>::encode (BufferView const& input) {
     Buffer output;
-    BufferBitWriter writer(output);
+    encode(input, output);
+    return output;
+}
+
+template <typename Word>
+void BasicHuffman<Word>::encode (BufferView const& input, Buffer& output) {
+    output.clear();
+    BasicBufferBitWriter<Word> writer(output);
 
-    // We process only the characters upt to the last word. The last word is
-    // possibly not aligned.
-    int const char_cnt = (input.size() / WORD_BITS) * WORD_CHARS;
+    // We process only the characters up to the last word. The last word is
+    // possibly not aligned. The chars are taken from the bit sequence rather
+    // than from memory, whose order depends on the word width.
+    int64_t const char_cnt =
+        (input.size() / WordTraits<Word>::BITS) * WordTraits<Word>::CHARS;
 
     // First pass is to count the weights of each letter. And produce the code
     // tree.
-    std::vector<int> weights(CHAR_CNT, 0);
-    BufferCharReader wreader(input);
-    for (int i = 0; i < char_cnt; ++i)
-        ++weights[char_to_word(wreader.get())];
+    std::vector<int64_t> weights(CHAR_CNT, 0);
+    BasicBufferBitReader<Word> wreader(input);
+    for (int64_t i = 0; i < char_cnt; ++i)
+        ++weights[wreader.get(CHAR_BITS)];
     Node const* root = make_tree(weights);
 
-    // The weights have to be stored for decoding.
-    for (int w : weights)
-        writer.put(w, INT_BITS);
+    // The weights have to be stored for decoding. They may exceed 32 bits for
+    // large inputs, but are mostly much smaller, so they all take just as many
+    // bits as the largest one needs, which is stored first.
+    int64_t const max_weight =
+        *std::max_element(weights.begin(), weights.end());
+    int const weight_bits = ceil_log2(max_weight + 1);
+    writer.put(weight_bits, WEIGHT_BITS_BITS);
+    for (int64_t w : weights) {
+        if (weight_bits > INT_BITS)
+            writer.put(Word(w >> INT_BITS), weight_bits - INT_BITS);
+        writer.put(Word(w & 0xFFFFFFFF), min(weight_bits, INT_BITS));
+    }
 
     // Next comes the last word, which is stored explicitly, along with the
-    // remaining length.
-    writer.put(input.size() - CHAR_BITS * char_cnt, INT_BITS);
-    writer.put(wreader.last_word(), WORD_BITS);
+    // remaining length. It is widened to 64 bits, keeping the bits in use on
+    // top, so that any word width can read it.
+    writer.put(input.size() - CHAR_BITS * char_cnt, TAIL_CNT_BITS);
+    writer.put64(uint64_t(BasicBufferCharReader<Word>(input).last_word())
+        << (64 - WordTraits<Word>::BITS));
 
     // Then the code tree is traversed in a BFS manner to retrieve codes for
     // all characters. The queue holds `(node, code)` triples of the nodes
@@ -35,16 +57,16 @@ Buffer Huffman::encode (Buffer const& input) {
     // final result is a code for each char represented as `(word, length)`
     // meaning that the `length` least significant bits of `word` is the code.
 
-    std::queue<pair<Node const*, word>> queue;
-    std::queue<pair<Node const*, word>> next_queue;
-    std::vector<pair<word, int>> codes(CHAR_CNT);
-    queue.emplace(root, NULL_WORD);
+    std::queue<pair<Node const*, Word>> queue;
+    std::queue<pair<Node const*, Word>> next_queue;
+    std::vector<pair<Word, int>> codes(CHAR_CNT);
+    queue.emplace(root, WordTraits<Word>::NULL_WORD);
     int length = 0;
     while (!queue.empty()) {
         while (!queue.empty()) {
             auto nc = queue.front();
             Node const* node = nc.first;
-            word code = nc.second;
+            Word code = nc.second;
             queue.pop();
             if (node->is_leaf()) {
                 codes[node->value()] = make_pair(code, length);
@@ -57,60 +79,102 @@ Buffer Huffman::encode (Buffer const& input) {
         ++length;
     }
 
+    // The exact size of the output is known by now, so it can be allocated
+    // at once.
+    int64_t output_bits = output.size();
+    for (int a = 0; a < CHAR_CNT; ++a)
+        output_bits += weights[a] * codes[a].second;
+    output.reserve(output_bits);
+
     // Now we can smooth sail and output the codes.
-    BufferCharReader reader(input);
-    for (int i = 0; i < char_cnt; ++i) {
-        auto cl = codes[char_to_word(reader.get())];
+    BasicBufferBitReader<Word> reader(input);
+    for (int64_t i = 0; i < char_cnt; ++i) {
+        auto cl = codes[reader.get(CHAR_BITS)];
         writer.put(cl.first, cl.second);
     }
+    writer.flush();
 
     delete root;
-    return output;
 }
 
-Buffer Huffman::decode (Buffer const& output) {
+template <typename Word>
+BasicBuffer<Word> BasicHuffman<Word>::decode (BufferView const& output) {
     Buffer input;
-    BufferCharWriter writer(input);
-    BufferBitReader reader(output);
+    decode(output, input);
+    return input;
+}
 
-    // First we read the character weights to build the code tree.
-    std::vector<int> weights(CHAR_CNT, 0);
-    for (int a = 0; a < CHAR_CNT; ++a)
-        weights[a] = reader.get(INT_BITS);
+template <typename Word>
+void BasicHuffman<Word>::decode (BufferView const& output, Buffer& input) {
+    input.clear();
+    BasicBufferBitReader<Word> reader(output);
+
+    // First we read the character weights to build the code tree. They add up
+    // to the number of chars to decode, so the input can be allocated at
+    // once.
+    std::vector<int64_t> weights(CHAR_CNT, 0);
+    int64_t char_cnt = 0;
+    int const weight_bits = reader.get(WEIGHT_BITS_BITS);
+    for (int a = 0; a < CHAR_CNT; ++a) {
+        weights[a] = reader.peek(weight_bits);
+        reader.consume(weight_bits);
+        char_cnt += weights[a];
+    }
+    input.reserve(char_cnt * CHAR_BITS + 64);
     Node const* root = make_tree(weights);
 
     // Remember that the last word is stored explicitly.
-    int remaining_bits = reader.get(INT_BITS);
-    word last_word = reader.get(WORD_BITS);
+    int remaining_bits = reader.get(TAIL_CNT_BITS);
+    uint64_t last_word = reader.get64();
 
     // Now the tree can be used as an automaton.
-    Node const* node = root;
-    while (!reader.eob()) {
-        assert(!node->is_leaf());
-        node = node->child(reader.get(1));
-        if (node->is_leaf()) {
-            writer.put(node->value());
-            node = root;
+    {
+        BasicBufferBitWriter<Word> writer(input);
+        Node const* node = root;
+        while (!reader.eob()) {
+            assert(!node->is_leaf());
+            node = node->child(reader.get(1));
+            if (node->is_leaf()) {
+                writer.put(node->value(), CHAR_BITS);
+                node = root;
+            }
         }
     }
-
-    // And finally the last word
-    writer.put_last_word(last_word, remaining_bits);
-
     delete root;
-    return input;
+
+    // And finally the last word. If it was encoded with the same word width,
+    // it is restored as it was, chars written into its memory included.
+    // Otherwise only the bits in use are carried over, in order.
+    int const bits = WordTraits<Word>::BITS;
+    if (input.size() % bits == 0 && remaining_bits < bits) {
+        BasicBufferCharWriter<Word>(input).put_last_word(
+            last_word >> (64 - bits),
+            remaining_bits
+        );
+    } else {
+        BasicBufferBitWriter<Word> writer(input);
+        while (remaining_bits > 0) {
+            int const bit_cnt = min(remaining_bits, INT_BITS);
+            writer.put(last_word >> (64 - bit_cnt), bit_cnt);
+            last_word <<= bit_cnt;
+            remaining_bits -= bit_cnt;
+        }
+    }
 }
 
-inline bool Huffman::NodeCompare::operator () (
-    Huffman::Node const* n1,
-    Huffman::Node const* n2
+template <typename Word>
+inline bool BasicHuffman<Word>::NodeCompare::operator () (
+    Node const* n1,
+    Node const* n2
 ) const {
     return n1->weight() != n2->weight()
         ? n1->weight() > n2->weight()
         : n1->size() > n2->size();
 }
 
-Huffman::Node const* Huffman::make_tree (std::vector<int> const& weights) {
+template <typename Word>
+typename BasicHuffman<Word>::Node const*
+BasicHuffman<Word>::make_tree (std::vector<int64_t> const& weights) {
     assert (weights.size() == CHAR_CNT);
 
     std::priority_queue<Node const*, std::vector<Node const*>, NodeCompare>
@@ -128,10 +192,11 @@ Huffman::Node const* Huffman::make_tree (std::vector<int> const& weights) {
     return queue.top();
 }
 
-// Huffman::Node
+// BasicHuffman::Node
 // =============================================================================
 
-inline Huffman::Node::Node (int value, int weight) :
+template <typename Word>
+inline BasicHuffman<Word>::Node::Node (int value, int64_t weight) :
     m_one_child(nullptr),
     m_value(value),
     m_weight(weight),
@@ -140,7 +205,11 @@ inline Huffman::Node::Node (int value, int weight) :
     /* Do nothing. */
 }
 
-inline Huffman::Node::Node (Node const* one_child, Node const* zero_child) :
+template <typename Word>
+inline BasicHuffman<Word>::Node::Node (
+    Node const* one_child,
+    Node const* zero_child
+) :
     m_one_child(one_child),
     m_zero_child(zero_child),
     m_weight(one_child->m_weight + zero_child->m_weight),
@@ -150,31 +219,44 @@ inline Huffman::Node::Node (Node const* one_child, Node const* zero_child) :
     assert(zero_child != nullptr);
 }
 
-Huffman::Node::~Node () {
+template <typename Word>
+BasicHuffman<Word>::Node::~Node () {
     if (!this->is_leaf()) {
         delete m_one_child;
         delete m_zero_child;
     }
 }
 
-inline Huffman::Node const* Huffman::Node::child (bool branch) const {
+template <typename Word>
+inline typename BasicHuffman<Word>::Node const*
+BasicHuffman<Word>::Node::child (bool branch) const {
     assert(!this->is_leaf());
     return branch ? m_one_child : m_zero_child;
 }
 
-inline bool Huffman::Node::is_leaf () const {
+template <typename Word>
+inline bool BasicHuffman<Word>::Node::is_leaf () const {
     return m_one_child == nullptr;
 }
 
-inline int Huffman::Node::value () const {
+template <typename Word>
+inline int BasicHuffman<Word>::Node::value () const {
     assert(this->is_leaf());
     return m_value;
 }
 
-inline int Huffman::Node::weight () const {
+template <typename Word>
+inline int64_t BasicHuffman<Word>::Node::weight () const {
     return m_weight;
 }
 
-inline int Huffman::Node::size () const {
+template <typename Word>
+inline int BasicHuffman<Word>::Node::size () const {
     return m_size;
 }
+
+// Instantiations
+// =============================================================================
+
+template class BasicHuffman<uint32_t>;
+template class BasicHuffman<uint64_t>;
@@ -6,20 +6,35 @@
 
 #include "buffer.h"
 
-// Huffman
+// BasicHuffman
 // =============================================================================
 //
-// TODO doc
-class Huffman {
+// The whole words of the input are coded as a sequence of bits, eight at
+// a time, and the last word is stored as it is. The encoding is a sequence of
+// bits as well, none of its fields depending on the width of `Word`, so that
+// an encoding made with one width decodes with the other to the same bits.
+template <typename Word>
+class BasicHuffman {
 public:
-    static Buffer encode (Buffer const& input);
+    typedef BasicBuffer<Word> Buffer;
+    typedef BasicBufferView<Word> BufferView;
+
+    static Buffer encode (BufferView const& input);
+
+    // Encodes `input` into `output`, discarding the previous contents of
+    // `output` but reusing its data array.
+    static void encode (BufferView const& input, Buffer& output);
 
-    static Buffer decode (Buffer const& output);
+    static Buffer decode (BufferView const& output);
+
+    // Decodes `output` into `input`, discarding the previous contents of
+    // `input` but reusing its data array.
+    static void decode (BufferView const& output, Buffer& input);
 
 private:
     class Node {
     public:
-        Node (int value, int weight);
+        Node (int value, int64_t weight);
 
         Node (Node const* one_child, Node const* zero_child);
 
@@ -31,7 +46,7 @@ private:
 
         int value () const;
 
-        int weight () const;
+        int64_t weight () const;
         
         int size () const;
 
@@ -42,7 +57,7 @@ private:
 
         int m_value;
 
-        int m_weight;
+        int64_t m_weight;
         
         int m_size;
     };
@@ -51,7 +66,19 @@ private:
         bool operator () (Node const* n1, Node const* n2) const;
     };
 
-    static Node const* make_tree (std::vector<int> const& weights);
+    // Number of bits storing the width of the char weights.
+    static int const WEIGHT_BITS_BITS = 6;
+
+    // Number of bits storing the number of bits in use in the last word.
+    static int const TAIL_CNT_BITS = 6;
+
+    static Node const* make_tree (std::vector<int64_t> const& weights);
 };
 
+// Huffman
+// =============================================================================
+//
+// The coder for the default `word`.
+typedef BasicHuffman<word> Huffman;
+
 #endif // HUFFMAN_H
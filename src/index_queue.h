@@ -0,0 +1,123 @@
+#ifndef INDEX_QUEUE_H
+#define INDEX_QUEUE_H
+
+#include "prefix.h"
+#include <vector>
+
+// IndexQueue
+// =============================================================================
+//
+// A queue of distinct integers from range `[1, capacity]`, which can also be
+// removed from the middle or inserted anywhere. It is the discard queue of the
+// codeword pools, ordering codewords by the time of use.
+//
+// The queue is a doubly linked list threaded through two arrays indexed by the
+// elements themselves, so that finding an element is just indexing and no
+// operation allocates. Index `0`, which is never an element, is the head of
+// the list, its neighbours being the back and the front of the queue.
+class IndexQueue {
+public:
+    // Creates an empty queue for elements up to `capacity`.
+    explicit IndexQueue (int capacity);
+
+    bool empty () const;
+
+    // Returns the first element. The queue must not be empty.
+    int front () const;
+
+    // Tells whether `i` is in the queue.
+    bool contains (int i) const;
+
+    // Adds `i`, which must not be in the queue, to the front.
+    void push_front (int i);
+
+    // Adds `i`, which must not be in the queue, to the back.
+    void push_back (int i);
+
+    // Adds `i`, which must not be in the queue, right in front of `pos`, which
+    // must be.
+    void insert (int pos, int i);
+
+    // Removes `i`, which must be in the queue.
+    void erase (int i);
+
+    // Moves `i`, which must be in the queue, to the back.
+    void move_to_back (int i);
+
+    // Removes all elements. It takes time proportional to their number.
+    void clear ();
+
+private:
+    // The neighbours of the elements towards the back and towards the front.
+    // Elements out of the queue have `m_prev` set to `-1`.
+    std::vector<int> m_next;
+    std::vector<int> m_prev;
+
+    // Links `i` between `prev` and `next`.
+    void link (int prev, int i, int next);
+};
+
+inline IndexQueue::IndexQueue (int capacity) :
+    m_next(capacity + 1, 0),
+    m_prev(capacity + 1, -1)
+{
+    m_prev[0] = 0;
+}
+
+inline bool IndexQueue::empty () const {
+    return m_next[0] == 0;
+}
+
+inline int IndexQueue::front () const {
+    assert(!empty());
+    return m_next[0];
+}
+
+inline bool IndexQueue::contains (int i) const {
+    assert(0 < i && i < m_prev.size());
+    return m_prev[i] != -1;
+}
+
+inline void IndexQueue::push_front (int i) {
+    link(0, i, m_next[0]);
+}
+
+inline void IndexQueue::push_back (int i) {
+    link(m_prev[0], i, 0);
+}
+
+inline void IndexQueue::insert (int pos, int i) {
+    assert(contains(pos));
+    link(m_prev[pos], i, pos);
+}
+
+inline void IndexQueue::erase (int i) {
+    assert(contains(i));
+    int const prev = m_prev[i];
+    int const next = m_next[i];
+    m_next[prev] = next;
+    m_prev[next] = prev;
+    m_prev[i] = -1;
+}
+
+inline void IndexQueue::move_to_back (int i) {
+    erase(i);
+    push_back(i);
+}
+
+inline void IndexQueue::clear () {
+    for (int i = m_next[0]; i != 0; i = m_next[i])
+        m_prev[i] = -1;
+    m_next[0] = 0;
+    m_prev[0] = 0;
+}
+
+inline void IndexQueue::link (int prev, int i, int next) {
+    assert(!contains(i));
+    m_next[prev] = i;
+    m_prev[i] = prev;
+    m_next[i] = next;
+    m_prev[next] = i;
+}
+
+#endif // INDEX_QUEUE_H
@@ -4,6 +4,7 @@
 #include "prefix.h"
 
 #include "buffer.h"
+#include "decode_sink.h"
 #include "dict.h"
 
 // Lz
@@ -13,33 +14,91 @@
 class Lz {
 public:
     // Constructs a new LZ encoder/decoder with a dictionary of given limit.
-    Lz (int dictionary_limit);
+    // Codeword numbers take up as many bits as the greatest possible number
+    // needs, unless `variable_width` is set. Then each one is written with
+    // just as many bits as the greatest number in the dictionary at that time
+    // needs, so the early codewords of a large dictionary come cheaper. The
+    // encoder and decoder have to agree on this setting.
+    Lz (int dictionary_limit, bool variable_width);
 
     virtual ~Lz ();
 
-    // Encode the `input` buffer interpreted as sequence of chars.
-    virtual Buffer encode (Buffer const& input) const = 0;
+    // Encode the `input` buffer interpreted as sequence of chars. Both whole
+    // buffers and char aligned views of them are accepted.
+    Buffer encode (BufferView const& input) const;
+
+    // Encode the `input` buffer into `output`. The previous contents of
+    // `output` are discarded, but its data array is reused, so encoding into
+    // the same buffer over and over doesn't allocate once it's large enough.
+    virtual void encode (BufferView const& input, Buffer& output) const = 0;
 
     // Decode the `output` buffer. The resulting buffer is can be read as
     // a sequence of chars. This is an iverse operation to `encode()`.
-    virtual Buffer decode (Buffer const& output) const = 0;
+    Buffer decode (BufferView const& output) const;
+
+    // Decode the `output` buffer into `input`, reusing its data array like
+    // `encode(BufferView const&, Buffer&)` does.
+    virtual void decode (BufferView const& output, Buffer& input) const = 0;
+
+    // Decode the `output` buffer and pass the result to `sink` in chunks. The
+    // dictionary used owns the text of its codewords, so the decoded data is
+    // not retained and the memory used depends only on the dictionary limit.
+    virtual void decode (BufferView const& output, DecodeSink& sink) const = 0;
 
-    // Return the size of a single codeword in bits.
+    // Decode the `output` buffer into `char_cnt` chars of memory starting at
+    // `input`, where `char_cnt` is exactly the decoded length. This lets the
+    // decoded data be placed right where it belongs, e.g., in a part of
+    // a larger buffer presized with `BufferCharWriter::append()`.
+    virtual void decode (
+        BufferView const& output,
+        char* input,
+        int64_t char_cnt
+    ) const = 0;
+
+    // Return the size of a single codeword in bits. With variable width
+    // codeword numbers this is the size of the widest one.
     virtual int codeword_bits () const = 0;
 
+    // Returns an upper bound for the size in bits of the encoding of an input
+    // consisting of `char_cnt` chars. Every codeword stands for at least one
+    // char, so there are at most as many codewords as chars.
+    int64_t max_encoded_bits (int64_t char_cnt) const;
+
+    // Returns the number of codewords in `output`, an encoding made by this
+    // coder. With variable width codeword numbers each codeword is taken to be
+    // as wide as `codeword_bits()` says, so the result is only a lower bound.
+    int64_t min_codeword_cnt (BufferView const& output) const;
+
+    // Tells whether codeword numbers are written with variable width.
+    bool variable_width () const;
+
 protected:
+    // Every encoding starts with a header holding the number of chars of the
+    // input, so that the decoder can allocate the output upfront. Encodings
+    // produced by `StreamEncoder` don't know it in advance and store `0`.
+    static int const HEADER_BITS = 64;
+
     // TODO: Naming
     int const m_dictionary_limit;
     int const m_codeword_no_length;
+    bool const m_variable_width;
+
+    // Returns the number of bits of the next codeword number, where
+    // `max_codeword_no` is the greatest number in the dictionary before the
+    // codeword gets extended. The encoder has to take it before the match
+    // adds a new codeword, as that is the dictionary the decoder reads with.
+    int codeword_no_length (int max_codeword_no) const;
 };
 
-inline Lz::Lz (int dictionary_limit) :
+inline Lz::Lz (int dictionary_limit, bool variable_width) :
     m_dictionary_limit(max(0, dictionary_limit)),
+    // Codeword numbers range from `0` to the limit inclusive.
     m_codeword_no_length(
         m_dictionary_limit > 0
-            ? ceil_log2(m_dictionary_limit)
-            : WORD_BITS
-    )
+            ? ceil_log2(int64_t(m_dictionary_limit) + 1)
+            : INT_BITS
+    ),
+    m_variable_width(variable_width)
 {
     /* Do nothing */
 }
@@ -48,4 +107,35 @@ inline Lz::~Lz () {
     /* Do nothing. */
 }
 
+inline Buffer Lz::encode (BufferView const& input) const {
+    Buffer output;
+    encode(input, output);
+    return output;
+}
+
+inline Buffer Lz::decode (BufferView const& output) const {
+    Buffer input;
+    decode(output, input);
+    return input;
+}
+
+inline int Lz::codeword_no_length (int max_codeword_no) const {
+    return m_variable_width
+        ? ceil_log2(int64_t(max_codeword_no) + 1)
+        : m_codeword_no_length;
+}
+
+inline int64_t Lz::max_encoded_bits (int64_t char_cnt) const {
+    return HEADER_BITS + char_cnt * codeword_bits();
+}
+
+inline int64_t Lz::min_codeword_cnt (BufferView const& output) const {
+    assert(output.size() >= HEADER_BITS);
+    return (output.size() - HEADER_BITS) / codeword_bits();
+}
+
+inline bool Lz::variable_width () const {
+    return m_variable_width;
+}
+
 #endif // LZ_H
@@ -5,6 +5,9 @@
 
 #include "lz.h"
 
+template <typename LzType> class PresetDict;
+template <typename LzType> class StreamEncoder;
+
 // Lz78
 // =============================================================================
 //
@@ -12,82 +15,170 @@
 template <typename DictPair>
 class Lz78 : public Lz {
 public:
-    // Construct an LZ78 encoder/decoder with given dictionary limit.
-    Lz78 (int dictionary_limit);
+    // Construct an LZ78 encoder/decoder with given dictionary limit. See
+    // `Lz::Lz()` for `variable_width`.
+    Lz78 (int dictionary_limit, bool variable_width = false);
+
+    using Lz::encode;
+    using Lz::decode;
+
+    // Implements `Lz::encode(BufferView const&, Buffer&) const`.
+    virtual void encode (BufferView const& input, Buffer& output) const;
 
-    // Implements `Lz::encode(Buffer const&) const`.
-    virtual Buffer encode(Buffer const& input) const;
+    // Implements `Lz::decode(BufferView const&, Buffer&) const`.
+    virtual void decode (BufferView const& output, Buffer& input) const;
 
-    // Implements `Lz::decode(Buffer const&) const`.
-    virtual Buffer decode(Buffer const& output) const;
+    // Implements `Lz::decode(BufferView const&, DecodeSink&) const`.
+    virtual void decode (BufferView const& output, DecodeSink& sink) const;
+
+    // Implements `Lz::decode(BufferView const&, char*, int64_t) const`.
+    virtual void decode (
+        BufferView const& output,
+        char* input,
+        int64_t char_cnt
+    ) const;
 
     // Implements `Lz::codeword_bits () const`.
     virtual int codeword_bits () const;
+
+private:
+    typedef typename DictPair::EncodeDict EncodeDict;
+    typedef typename DictPair::LinkDecodeDict LinkDecodeDict;
+
+    // LZ78 dictionaries start empty.
+    static bool const SINGLE_CHAR_CODEWORDS = false;
+
+    // Encodes the input attached to `dict` codeword by codeword. Unless `last`
+    // is set, the partial match at the end of input is left unencoded and
+    // `dict` stays at its beginning, as more input may extend it.
+    void factorize (EncodeDict& dict, BufferBitWriter& writer, bool last) const;
+
+    // Decodes the codewords from `reader` with `writer`, which is either
+    // a `BufferCharWriter` or a `CharArrayWriter`.
+    template <typename Writer>
+    void unfactorize (BufferBitReader& reader, Writer& writer) const;
+
+    // Decodes the codewords from `reader` with `dict`, which may have been
+    // trained beforehand, passing the result to `writer`.
+    void unfactorize (
+        LinkDecodeDict& dict,
+        BufferBitReader& reader,
+        SinkWriter& writer
+    ) const;
+
+    friend class PresetDict<Lz78>;
+    friend class StreamEncoder<Lz78>;
 };
 
 template <typename DictPair>
-Lz78<DictPair>::Lz78 (int dictionary_limit) :
-    Lz(dictionary_limit)
+Lz78<DictPair>::Lz78 (int dictionary_limit, bool variable_width) :
+    Lz(dictionary_limit, variable_width)
 {
     /* Do nothing */
 }
 
 template <typename DictPair>
-Buffer Lz78<DictPair>::encode (Buffer const& input) const {
-    typename DictPair::EncodeDict dict(input, m_dictionary_limit, false);
-    Buffer output;
+void Lz78<DictPair>::encode (
+    BufferView const& input,
+    Buffer& output
+) const {
+    EncodeDict dict(input, m_dictionary_limit, SINGLE_CHAR_CODEWORDS);
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    output.clear();
+    output.reserve(max_encoded_bits(char_cnt));
     BufferBitWriter writer(output);
+    writer.put64(char_cnt);
+    factorize(dict, writer, true);
+    writer.flush();
+}
 
-    // Number of positions ahead of the encoded part.
-    int ahead = 0;
-    // The outer loop iterates only at the end of the processed input and is
-    // due to the presence of artificial terminating character.
+template <typename DictPair>
+void Lz78<DictPair>::factorize (
+    EncodeDict& dict,
+    BufferBitWriter& writer,
+    bool last
+) const {
     while (!dict.eob()) {
-        // Most of the work is done in this loop.
-        while (!dict.eob()) {
-            Match match = dict.try_char();
-            ++ahead;
-            if (match.is_maximal()) {
-                writer.put(match.codeword_no, m_codeword_no_length);
-                writer.put(char_to_word(match.extending_char), CHAR_BITS);
-                dict.put_back(ahead - match.length - 1);
-                ahead = 0;
-            }
+        int const codeword_no_length =
+            this->codeword_no_length(dict.max_codeword_no());
+        Match match = dict.next_match(last);
+        if (!match.is_maximal()) {
+            // The match may go on in the input to come.
+            return;
         }
-        if (ahead != 0) {
-            // We reached the end of input but still have some partially matched
-            // prefix. Behave as if a special terminating char was present.
-            // Notice that `ahead` is not incremented.
-            Match match = dict.fail_char();
-            writer.put(match.codeword_no, m_codeword_no_length);
-            if (match.length != ahead) {
-                // The match terminates before the end of input, i.e.,
-                // `match.extending_char` is some valid char. We write it and
-                // prepare for another round.
-                writer.put(match.extending_char, CHAR_BITS);
-                dict.put_back(ahead - match.length - 1);
-                ahead = 0;
-            }
+        if (dict.eob()) {
+            // The match took up the rest of the input, so there is no
+            // extending char.
+            writer.put(match.codeword_no, codeword_no_length);
+        } else {
+            writer.put2(
+                match.codeword_no, codeword_no_length,
+                char_to_word(match.extending_char), CHAR_BITS
+            );
+            dict.skip(1);
         }
     }
-
-    return output;
 }
 
 template <typename DictPair>
-Buffer Lz78<DictPair>::decode (Buffer const& output) const {
-    typename DictPair::DecodeDict dict(m_dictionary_limit, false);
-    Buffer input;
+void Lz78<DictPair>::decode (
+    BufferView const& output,
+    Buffer& input
+) const {
+    BufferBitReader reader(output);
+    int64_t const char_cnt = reader.get64();
+    input.clear();
     BufferCharWriter writer(input);
+    if (char_cnt == 0) {
+        // The length is unknown, the buffer grows as needed.
+        unfactorize(reader, writer);
+        return;
+    }
+    // The chars are decoded in place, with some slack for the copies to spill
+    // into.
+    input.reserve((char_cnt + CharArrayWriter::CHUNK) * CHAR_BITS);
+    CharArrayWriter array_writer(
+        writer.append(char_cnt),
+        char_cnt,
+        CharArrayWriter::CHUNK
+    );
+    unfactorize(reader, array_writer);
+    assert(array_writer.pos() == char_cnt);
+    // This clears the spilled chars sharing the last word with the decoded
+    // ones.
+    writer.append(0);
+}
+
+template <typename DictPair>
+void Lz78<DictPair>::decode (
+    BufferView const& output,
+    char* input,
+    int64_t char_cnt
+) const {
     BufferBitReader reader(output);
+    int64_t const header = reader.get64();
+    assert(header == char_cnt || header == 0);
+    UNUSED(header);
+    CharArrayWriter writer(input, char_cnt);
+    unfactorize(reader, writer);
+    assert(writer.pos() == char_cnt);
+}
+
+template <typename DictPair>
+template <typename Writer>
+void Lz78<DictPair>::unfactorize (
+    BufferBitReader& reader,
+    Writer& writer
+) const {
+    typename DictPair::DecodeDict dict(m_dictionary_limit, false);
 
     // Starting position of the part not decoded yet.
-    int pos = 0;
+    int64_t pos = 0;
     while (!reader.eob()) {
-        int i = reader.get(m_codeword_no_length);
+        int i = reader.get(codeword_no_length(dict.max_codeword_no()));
         Codeword cw = dict.codeword(i);
         dict.add_extension(i, pos);
-        writer.put(BufferCharSlice(input, cw.begin, cw.length));
+        writer.put_copy(cw.begin, cw.length);
         pos += cw.length;
         // If this was the last codeword, no extending character follows.
         if (!reader.eob()) {
@@ -95,8 +186,37 @@ Buffer Lz78<DictPair>::decode (Buffer const& output) const {
             ++pos;
         }
     }
+}
 
-    return input;
+template <typename DictPair>
+void Lz78<DictPair>::decode (
+    BufferView const& output,
+    DecodeSink& sink
+) const {
+    LinkDecodeDict dict(m_dictionary_limit, SINGLE_CHAR_CODEWORDS);
+    BufferBitReader reader(output);
+    // The decoded length is of no use here.
+    reader.get64();
+    SinkWriter writer(sink);
+    unfactorize(dict, reader, writer);
+}
+
+template <typename DictPair>
+void Lz78<DictPair>::unfactorize (
+    LinkDecodeDict& dict,
+    BufferBitReader& reader,
+    SinkWriter& writer
+) const {
+    while (!reader.eob()) {
+        int i = reader.get(codeword_no_length(dict.max_codeword_no()));
+        dict.spell(i, writer.append(dict.length(i)));
+        // If this was the last codeword, no extending character follows.
+        if (!reader.eob()) {
+            char a = reader.get(CHAR_BITS);
+            dict.add_extension(i, a);
+            writer.put(a);
+        }
+    }
 }
 
 template <typename DictPair>
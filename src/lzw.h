@@ -5,6 +5,9 @@
 
 #include "lz.h"
 
+template <typename LzType> class PresetDict;
+template <typename LzType> class StreamEncoder;
+
 // Lzw
 // =============================================================================
 //
@@ -15,80 +18,239 @@ public:
     // Constructs an LZW encoder/decoder with given dictionary limit. The
     // actual limit of the dictionary used is expanded by `CHAR_CNT` as this
     // particular method adds all single-letter codewords to the dictionary.
-    Lzw (int dictionary_limit);
+    // See `Lz::Lz()` for `variable_width`.
+    //
+    // With `adaptive_reset` set, the encoder watches the compression ratio
+    // once the dictionary is full, like Unix `compress` does. Whenever the
+    // input since the last check compresses notably worse than before, the
+    // encoder writes `CLEAR_CODEWORD_NO` and both sides start over with
+    // a fresh dictionary. The decoder handles it regardless of the setting.
+    Lzw (
+        int dictionary_limit,
+        bool variable_width = false,
+        bool adaptive_reset = false
+    );
+
+    using Lz::encode;
+    using Lz::decode;
+
+    // Implements `Lz::encode(BufferView const&, Buffer&) const`.
+    virtual void encode (BufferView const& input, Buffer& output) const;
 
-    // Implements `Lz::encode(Buffer const&) const`.
-    virtual Buffer encode(Buffer const& input) const;
+    // Implements `Lz::decode(BufferView const&, Buffer&) const`.
+    virtual void decode (BufferView const& output, Buffer& input) const;
 
-    // Implements `Lz::decode(Buffer const&) const`.
-    virtual Buffer decode(Buffer const& output) const;
+    // Implements `Lz::decode(BufferView const&, DecodeSink&) const`.
+    virtual void decode (BufferView const& output, DecodeSink& sink) const;
+
+    // Implements `Lz::decode(BufferView const&, char*, int64_t) const`.
+    virtual void decode (
+        BufferView const& output,
+        char* input,
+        int64_t char_cnt
+    ) const;
 
     // Implements `Lz::codeword_bits () const`.
     virtual int codeword_bits () const;
+
+private:
+    typedef typename Dict::EncodeDict EncodeDict;
+    typedef typename Dict::LinkDecodeDict LinkDecodeDict;
+
+    // LZW dictionaries start with all the single letter codewords.
+    static bool const SINGLE_CHAR_CODEWORDS = true;
+
+    // The empty codeword never matches in LZW, so its number is free to tell
+    // the decoder to reset the dictionary.
+    static int const CLEAR_CODEWORD_NO = 0;
+
+    // Number of input chars between the checks of the compression ratio.
+    static int64_t const RESET_CHECK_CHAR_CNT = 1 << 13;
+
+    bool const m_adaptive_reset;
+
+    // Called after every codeword, `codeword_no_length` being the number of
+    // bits it took. Updates the statistics of `dict` and resets it if the
+    // compression ratio has got worse.
+    void check_ratio (
+        EncodeDict& dict,
+        BufferBitWriter& writer,
+        Match const& match,
+        int codeword_no_length
+    ) const;
+
+    // Encodes the input attached to `dict` codeword by codeword. Unless `last`
+    // is set, the partial match at the end of input is left unencoded and
+    // `dict` stays at its beginning, as more input may extend it.
+    void factorize (EncodeDict& dict, BufferBitWriter& writer, bool last) const;
+
+    // Decodes the codewords from `reader` with `writer`, which is either
+    // a `BufferCharWriter` or a `CharArrayWriter`.
+    template <typename Writer>
+    void unfactorize (BufferBitReader& reader, Writer& writer) const;
+
+    // Decodes the codewords from `reader` with `dict`, which may have been
+    // trained beforehand, passing the result to `writer`.
+    void unfactorize (
+        LinkDecodeDict& dict,
+        BufferBitReader& reader,
+        SinkWriter& writer
+    ) const;
+
+    friend class PresetDict<Lzw>;
+    friend class StreamEncoder<Lzw>;
 };
 
 template <typename Dict>
-Lzw<Dict>::Lzw (int dictionary_limit) :
-    Lz(dictionary_limit + CHAR_CNT)
+int64_t const Lzw<Dict>::RESET_CHECK_CHAR_CNT;
+
+template <typename Dict>
+Lzw<Dict>::Lzw (
+    int dictionary_limit,
+    bool variable_width,
+    bool adaptive_reset
+) :
+    Lz(dictionary_limit + CHAR_CNT, variable_width),
+    m_adaptive_reset(adaptive_reset)
 {
     /* Do nothing */
 }
 
 template <typename Dict>
-Buffer Lzw<Dict>::encode (Buffer const& input) const {
+void Lzw<Dict>::encode (
+    BufferView const& input,
+    Buffer& output
+) const {
     // In this method, a dictionary preoccupied with single letter codewords is
     // used.
-    typename Dict::EncodeDict dict(input, m_dictionary_limit, true);
-    Buffer output;
+    EncodeDict dict(input, m_dictionary_limit, SINGLE_CHAR_CODEWORDS);
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    output.clear();
+    output.reserve(max_encoded_bits(char_cnt));
     BufferBitWriter writer(output);
+    writer.put64(char_cnt);
+    factorize(dict, writer, true);
+    writer.flush();
+}
 
-    // Number of positions ahead of the encoded part.
-    int ahead = 0;
-    // The outer loop iterates only at the end of the processed input and is
-    // due to the presence of artificial terminating character.
+template <typename Dict>
+void Lzw<Dict>::factorize (
+    EncodeDict& dict,
+    BufferBitWriter& writer,
+    bool last
+) const {
     while (!dict.eob()) {
-        while (!dict.eob()) {
-            Match match = dict.try_char();
-            ++ahead;
-            if (match.is_maximal()) {
-                // Only the matching codeword number is written.
-                writer.put(match.codeword_no, m_codeword_no_length);
-                // We put back all chars up to the first unmatched one
-                // inclusive.
-                dict.put_back(ahead - match.length);
-                ahead = 0;
-            }
-        }
-        if (ahead != 0) {
-            // We reached the end of input but still have some partially matched
-            // prefix. Behave as if a special terminating char was present.
-            Match match = dict.fail_char();
-            writer.put(match.codeword_no, m_codeword_no_length);
-            if (match.length != ahead) {
-                // The match terminates before the end of input. We have to
-                // prepare for another round.
-                dict.put_back(ahead - match.length);
-                ahead = 0;
-            }
+        int const codeword_no_length =
+            this->codeword_no_length(dict.max_codeword_no());
+        Match match = dict.next_match(last);
+        if (!match.is_maximal()) {
+            // The match may go on in the input to come.
+            return;
         }
+        // Only the matching codeword number is written. The extending char
+        // starts the next match.
+        writer.put(match.codeword_no, codeword_no_length);
+        if (m_adaptive_reset)
+            check_ratio(dict, writer, match, codeword_no_length);
+    }
+}
+
+template <typename Dict>
+void Lzw<Dict>::check_ratio (
+    EncodeDict& dict,
+    BufferBitWriter& writer,
+    Match const& match,
+    int codeword_no_length
+) const {
+    EncodeStats& stats = dict.stats();
+    stats.char_cnt += match.length;
+    stats.bit_cnt += codeword_no_length;
+    if (stats.char_cnt - stats.checked_char_cnt < RESET_CHECK_CHAR_CNT)
+        return;
+    // Until the dictionary is full, every new codeword is worth its bits.
+    // Afterwards, the ratio of the input since the last check is compared to
+    // the overall one at that check. Evicting dictionaries fluctuate a bit on
+    // their own, so it takes a margin of an eighth to reset.
+    bool const full = dict.max_codeword_no() == m_dictionary_limit;
+    bool const worse = full && stats.checked_bit_cnt != 0 && (
+        8.0 * (stats.bit_cnt - stats.checked_bit_cnt)
+            / (stats.char_cnt - stats.checked_char_cnt) >
+        9.0 * stats.checked_bit_cnt / stats.checked_char_cnt
+    );
+    if (!worse) {
+        stats.checked_char_cnt = stats.char_cnt;
+        stats.checked_bit_cnt = full ? stats.bit_cnt : 0;
+        return;
     }
+    // The dictionary already holds the extension of the codeword just written.
+    // The decoder adds it before reading on, so both agree on the width.
+    writer.put(
+        CLEAR_CODEWORD_NO,
+        this->codeword_no_length(dict.max_codeword_no())
+    );
+    dict.reset();
+    stats = EncodeStats();
+}
 
-    return output;
+template <typename Dict>
+void Lzw<Dict>::decode (
+    BufferView const& output,
+    Buffer& input
+) const {
+    BufferBitReader reader(output);
+    int64_t const char_cnt = reader.get64();
+    input.clear();
+    BufferCharWriter writer(input);
+    if (char_cnt == 0) {
+        // The length is unknown, the buffer grows as needed.
+        unfactorize(reader, writer);
+        return;
+    }
+    // The chars are decoded in place, with some slack for the copies to spill
+    // into.
+    input.reserve((char_cnt + CharArrayWriter::CHUNK) * CHAR_BITS);
+    CharArrayWriter array_writer(
+        writer.append(char_cnt),
+        char_cnt,
+        CharArrayWriter::CHUNK
+    );
+    unfactorize(reader, array_writer);
+    assert(array_writer.pos() == char_cnt);
+    // This clears the spilled chars sharing the last word with the decoded
+    // ones.
+    writer.append(0);
 }
 
 template <typename Dict>
-Buffer Lzw<Dict>::decode (Buffer const& output) const {
+void Lzw<Dict>::decode (
+    BufferView const& output,
+    char* input,
+    int64_t char_cnt
+) const {
+    BufferBitReader reader(output);
+    int64_t const header = reader.get64();
+    assert(header == char_cnt || header == 0);
+    UNUSED(header);
+    CharArrayWriter writer(input, char_cnt);
+    unfactorize(reader, writer);
+    assert(writer.pos() == char_cnt);
+}
+
+template <typename Dict>
+template <typename Writer>
+void Lzw<Dict>::unfactorize (BufferBitReader& reader, Writer& writer) const {
     // In this method, a dictionary preoccupied with single letter codewords is
     // used.
     typename Dict::DecodeDict dict(m_dictionary_limit, true);
-    Buffer input;
-    BufferCharWriter writer(input);
-    BufferBitReader reader(output);
 
     // Starting position of the part not decoded yet.
-    int pos = 0;
+    int64_t pos = 0;
     while (!reader.eob()) {
-        int i = reader.get(m_codeword_no_length);
+        int i = reader.get(codeword_no_length(dict.max_codeword_no()));
+        if (i == CLEAR_CODEWORD_NO) {
+            dict.reset();
+            continue;
+        }
         Codeword cw = dict.codeword(i);
         dict.add_extension(i, pos);
         if (cw.length == 1) {
@@ -96,20 +258,49 @@ Buffer Lzw<Dict>::decode (Buffer const& output) const {
             // decoded text, but its number determines the letter instead.
             writer.put(i - 1);
         } else {
-            // This is an ordinary codeword. The first character of `cw` is the
-            // last character of the codeword created during the preceding
-            // iteration, and it wasn't known at that time. We have to
-            // explicitly handle that character because in case those two
-            // codewords are in fact the same, we might end up copying
-            // undefined data.
-            writer.put(BufferCharSlice(input, cw.begin, 1));
-            writer.put(BufferCharSlice(input, cw.begin + 1, cw.length - 1));
+            // This is an ordinary codeword. Its last character wasn't known
+            // when it was created. If that was during the preceding iteration,
+            // the character is the first one of `cw` and lies right where the
+            // copy starts writing, so the copy runs into its destination and
+            // supplies it.
+            writer.put_copy(cw.begin, cw.length);
         }
         // Notice that `pos` is advanced only by `cw.length`.
         pos += cw.length;
     }
+}
 
-    return input;
+template <typename Dict>
+void Lzw<Dict>::decode (
+    BufferView const& output,
+    DecodeSink& sink
+) const {
+    LinkDecodeDict dict(m_dictionary_limit, SINGLE_CHAR_CODEWORDS);
+    BufferBitReader reader(output);
+    // The decoded length is of no use here.
+    reader.get64();
+    SinkWriter writer(sink);
+    unfactorize(dict, reader, writer);
+}
+
+template <typename Dict>
+void Lzw<Dict>::unfactorize (
+    LinkDecodeDict& dict,
+    BufferBitReader& reader,
+    SinkWriter& writer
+) const {
+    while (!reader.eob()) {
+        int i = reader.get(codeword_no_length(dict.max_codeword_no()));
+        if (i == CLEAR_CODEWORD_NO) {
+            dict.reset();
+            continue;
+        }
+        // The codeword created during the preceding iteration is extended by
+        // the first char of this one, which may be that very codeword.
+        dict.set_extending_char(dict.first_char(i));
+        dict.spell(i, writer.append(dict.length(i)));
+        dict.add_extension(i);
+    }
 }
 
 template <typename Dict>
@@ -0,0 +1,55 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// MappedFile
+// =============================================================================
+
+// The borrowed buffer needs some aligned address even if nothing is mapped.
+static word const EMPTY_DATA = NULL_WORD;
+
+MappedFile::MappedFile (string const& path) :
+    m_length(0),
+    m_open(false),
+    m_data(map(path)),
+    m_buffer(m_data != nullptr ? m_data : &EMPTY_DATA, m_length)
+{
+    /* Do nothing. */
+}
+
+MappedFile::~MappedFile () {
+    if (m_data != nullptr)
+        munmap(m_data, m_length);
+}
+
+void* MappedFile::map (string const& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* data = nullptr;
+    if (st.st_size > 0) {
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        // The encoders mostly scan forward.
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+
+    m_length = st.st_size;
+    m_open = true;
+    return data;
+}
@@ -0,0 +1,58 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "prefix.h"
+
+#include "buffer.h"
+
+// MappedFile
+// =============================================================================
+//
+// A file mapped read-only into memory and exposed as a borrowed `Buffer`. This
+// allows a file to be encoded without copying it; the only memory used is the
+// page cache.
+class MappedFile {
+public:
+    // Maps the file at `path`. Whether it succeeded can be checked with
+    // `is_open()`. Empty files are not mapped, but still open successfully.
+    explicit MappedFile (string const& path);
+
+    ~MappedFile ();
+
+    // Returns `true` if the file has been successfully mapped.
+    bool is_open () const;
+
+    // Returns the contents of the file. The buffer is valid for as long as
+    // this object lives.
+    Buffer const& buffer () const;
+
+private:
+    // Length of the file in chars.
+    int64_t m_length;
+
+    // Whether the file has been opened successfully.
+    bool m_open;
+
+    // Start of the mapping. This is `nullptr` if nothing is mapped.
+    void* m_data;
+
+    // A buffer borrowing the mapped memory.
+    Buffer m_buffer;
+
+    // Maps the file and returns the starting address of the mapping, or
+    // `nullptr` on failure. Sets `m_length` and `m_open` as a side effect.
+    void* map (string const& path);
+
+    MappedFile (MappedFile const&) = delete;
+    MappedFile& operator = (MappedFile const&) = delete;
+};
+
+inline bool MappedFile::is_open () const {
+    return m_open;
+}
+
+inline Buffer const& MappedFile::buffer () const {
+    return m_buffer;
+}
+
+#endif // MAPPED_FILE_H
@@ -8,13 +8,16 @@
 // MraPool
 // =============================================================================
 // TODO doc
-class MraPool : public CodewordPool {
+class MraPool final : public CodewordPool {
 public:
     MraPool (int limit, bool single_char_codewords);
 
     // Implements `CodewordPool::match(int)`.
     virtual int match (int i);
 
+    // Drops all codewords but the permanent ones.
+    void reset ();
+
 private:
     int m_fixed;
     int m_next;
@@ -38,9 +41,17 @@ inline int MraPool::match (int i) {
     }
 }
 
+inline void MraPool::reset () {
+    m_next = m_fixed + 1;
+}
+
+// Mra
+// =============================================================================
+
 struct Mra {
     typedef PoolEncodeDict<MraPool> EncodeDict;
     typedef PoolDecodeDict<MraPool> DecodeDict;
+    typedef PoolLinkDecodeDict<MraPool> LinkDecodeDict;
 };
 
 #endif // MRA_DICT_H
@@ -15,9 +15,20 @@ class PoolDict : public Dict {
 public:
     explicit PoolDict (int limit, bool single_char_codewords);
 
+    // Returns the greatest codeword number handed out so far. Encoders and
+    // decoders call `match()` in the same order, so they agree on it at every
+    // step.
+    int max_codeword_no () const;
+
 protected:
     int match (int i);
 
+    // Brings the pool back to its initial state.
+    void reset ();
+
+    // Returns `CodewordPool::fixed_cnt()` of the pool.
+    int fixed_cnt () const;
+
 private:
     Pool m_pool;
     int m_max_codeword_no;
@@ -32,6 +43,11 @@ PoolDict<Pool>::PoolDict (int limit, bool single_char_codewords) :
     /* Do nothing. */
 }
 
+template <typename Pool>
+inline int PoolDict<Pool>::max_codeword_no () const {
+    return m_max_codeword_no;
+}
+
 template <typename Pool>
 inline int PoolDict<Pool>::match (int i) {
     assert(0 <= i && i <= m_max_codeword_no);
@@ -40,13 +56,28 @@ inline int PoolDict<Pool>::match (int i) {
     return result;
 }
 
+template <typename Pool>
+void PoolDict<Pool>::reset () {
+    m_pool.reset();
+    m_max_codeword_no = m_pool.fixed_cnt();
+}
+
+template <typename Pool>
+inline int PoolDict<Pool>::fixed_cnt () const {
+    return m_pool.fixed_cnt();
+}
+
 // PoolEncodeDict
 // =============================================================================
 // TODO doc
 template <typename Pool>
-class PoolEncodeDict : public PoolDict<Pool>, public EncodeDict {
+class PoolEncodeDict final : public PoolDict<Pool>, public EncodeDict {
 public:
-    PoolEncodeDict (Buffer const& input, int limit, bool single_char_codewords);
+    PoolEncodeDict (
+        BufferView const& input,
+        int limit,
+        bool single_char_codewords
+    );
 
     // Implements `EncodeDictBase::try_char()`.
     virtual Match try_char ();
@@ -54,6 +85,27 @@ public:
     // Implements `EncodeDictBase::fail_char()`.
     virtual Match fail_char ();
 
+    // Implements `EncodeDict::next_match()`. Edges are compared with the
+    // input several chars at a time.
+    virtual Match next_match (bool last);
+
+    // Constructs a copy of `dict` with its own tree. The dictionary has to be
+    // between matches.
+    PoolEncodeDict (PoolEncodeDict const& dict);
+
+    // Hides `EncodeDict::attach()`, as the tree has to be moved along.
+    void attach (BufferView const& input, int64_t pos);
+
+    // Copies the text of the tree into `text`. See `PoolDictTree::compact()`.
+    void compact (Buffer& text);
+
+    // Makes the tree own its text. See `PoolDictTree::detach()`.
+    void detach ();
+
+    // Drops all codewords but the permanent ones, as if the dictionary were
+    // constructed anew. The position within the input is kept.
+    void reset ();
+
 private:
     typedef PoolDictTree::Node Node;
     typedef PoolDictTree::Edge Edge;
@@ -62,17 +114,20 @@ private:
     Node const* m_node;
     Edge m_edge;
     Match m_match;
-    int m_match_begin;
-    int m_edge_pos;
+    int64_t m_match_begin;
+    int64_t m_edge_pos;
     
     void try_extend ();
     
     void reset_search ();
+
+    // Adds the single char codewords to the tree, if there are any.
+    void add_single_chars ();
 };
 
 template <typename Pool>
 PoolEncodeDict<Pool>::PoolEncodeDict (
-    Buffer const& input,
+    BufferView const& input,
     int limit,
     bool single_char_codewords
 ) :
@@ -80,17 +135,24 @@ PoolEncodeDict<Pool>::PoolEncodeDict (
     EncodeDict(input),
     m_tree(input)
 {
-    if (single_char_codewords) {
-        // Class `PoolDictTree` behaves as if the attached input were prepended
-        // with the whole alphabet with negative indices.
-        for (int a = 0; a < CHAR_CNT; ++a)
-            m_tree.extend(0, -a - 1, a + 1);
-    }
+    add_single_chars();
+    reset_search();
+}
+
+template <typename Pool>
+PoolEncodeDict<Pool>::PoolEncodeDict (PoolEncodeDict const& dict) :
+    PoolDict<Pool>(dict),
+    EncodeDict(dict),
+    m_tree(dict.m_tree),
+    m_match(dict.m_match),
+    m_match_begin(dict.m_match_begin)
+{
+    assert(dict.m_node->is_root() && dict.m_edge_pos == 0);
     reset_search();
 }
 
 template <typename Pool>
-Match PoolEncodeDict<Pool>::try_char () {
+inline Match PoolEncodeDict<Pool>::try_char () {
     char a = this->get_char();
     bool matches = false;
     if (m_edge_pos == 0) {
@@ -134,6 +196,83 @@ Match PoolEncodeDict<Pool>::fail_char () {
     return m_match;
 }
 
+template <typename Pool>
+Match PoolEncodeDict<Pool>::next_match (bool last) {
+    assert(m_node->is_root() && m_edge_pos == 0);
+    BufferCharSlice const text = this->lookahead();
+
+    Node const* node = m_tree.root();
+    // The deepest active node passed so far is the longest match.
+    Node const* match = node;
+    // Set if the input runs out before a mismatch is found.
+    bool ended = false;
+    // Set if the walk stopped right at `node` rather than along an edge.
+    bool at_node = true;
+    while (true) {
+        int64_t const depth = node->tag.length;
+        if (node->tag.active)
+            match = node;
+        if (depth == text.length()) {
+            ended = true;
+            break;
+        }
+        Edge const edge = m_tree.edge(node, text[depth]);
+        if (edge.dst == nullptr)
+            break;
+        BufferCharSlice const rest = text.slice(depth, text.length() - depth);
+        int64_t const matched = edge.match(rest);
+        if (matched < edge.length()) {
+            ended = (matched == rest.length());
+            at_node = false;
+            break;
+        }
+        node = edge.dst;
+    }
+
+    if (ended && !last)
+        return Match();
+
+    int64_t const length = match->tag.length;
+    m_match_begin = this->next_pos();
+    this->skip(length);
+    if (ended && at_node && node->tag.active) {
+        // The rest of the input is a codeword. Like in `fail_char()`, there is
+        // nothing to extend it with.
+        return Match(match->tag.codeword_no, length, '\0');
+    }
+    m_match = Match(match->tag.codeword_no, length, text[length]);
+    try_extend();
+    return m_match;
+}
+
+template <typename Pool>
+inline void
+PoolEncodeDict<Pool>::attach (BufferView const& input, int64_t pos) {
+    EncodeDict::attach(input, pos);
+    m_tree.attach(input);
+}
+
+template <typename Pool>
+inline void PoolEncodeDict<Pool>::compact (Buffer& text) {
+    // Match positions in the old input would be meaningless.
+    assert(m_node->is_root() && m_edge_pos == 0);
+    m_tree.compact(text);
+}
+
+template <typename Pool>
+inline void PoolEncodeDict<Pool>::detach () {
+    assert(m_node->is_root() && m_edge_pos == 0);
+    m_tree.detach();
+}
+
+template <typename Pool>
+void PoolEncodeDict<Pool>::reset () {
+    assert(m_node->is_root() && m_edge_pos == 0);
+    PoolDict<Pool>::reset();
+    m_tree.clear();
+    add_single_chars();
+}
+
 template <typename Pool>
 inline void PoolEncodeDict<Pool>::try_extend () {
     int i = m_match.codeword_no;
@@ -148,18 +287,32 @@ inline void PoolEncodeDict<Pool>::reset_search () {
     m_edge_pos = 0;
 }
 
+template <typename Pool>
+void PoolEncodeDict<Pool>::add_single_chars () {
+    if (this->fixed_cnt() != 0) {
+        // Class `PoolDictTree` behaves as if the attached input were prepended
+        // with the whole alphabet with negative indices.
+        for (int a = 0; a < CHAR_CNT; ++a)
+            m_tree.extend(0, -a - 1, a + 1);
+    }
+}
+
 // PoolDecodeDict
 // =============================================================================
 // TODO doc
 template <typename Pool>
-class PoolDecodeDict : public PoolDict<Pool>, public DecodeDict {
+class PoolDecodeDict final : public PoolDict<Pool>, public DecodeDict {
 public:
     PoolDecodeDict (int limit, bool single_char_codewords);
 
-    virtual void add_extension (int i, int begin);
+    virtual void add_extension (int i, int64_t begin);
 
     virtual Codeword codeword (int i) const;
 
+    // Drops all codewords but the permanent ones, as if the dictionary were
+    // constructed anew.
+    void reset ();
+
 private:
     std::vector<Codeword> m_codewords;
 };
@@ -169,14 +322,19 @@ PoolDecodeDict<Pool>::PoolDecodeDict (int limit, bool single_char_codewords) :
     PoolDict<Pool>(limit, single_char_codewords),
     m_codewords(limit + 1, Codeword(0, 0))
 {
-    if (single_char_codewords) {
-        for (int a = 0; a < CHAR_CNT; ++a)
-            m_codewords[a + 1].length = 1;
-    }
+    reset();
+}
+
+template <typename Pool>
+void PoolDecodeDict<Pool>::reset () {
+    PoolDict<Pool>::reset();
+    std::fill(m_codewords.begin(), m_codewords.end(), Codeword(0, 0));
+    for (int a = 0; a < this->fixed_cnt(); ++a)
+        m_codewords[a + 1].length = 1;
 }
 
 template <typename Pool>
-inline void PoolDecodeDict<Pool>::add_extension (int i, int begin) {
+inline void PoolDecodeDict<Pool>::add_extension (int i, int64_t begin) {
     assert(0 <= i && i < m_codewords.size());
     int j = this->match(i);
     if (j != 0)
@@ -189,6 +347,196 @@ inline Codeword PoolDecodeDict<Pool>::codeword (int i) const {
     return m_codewords[i];
 }
 
+// PoolLinkDecodeDict
+// =============================================================================
+//
+// A decode dictionary that owns the text of its codewords rather than
+// referring to the decoded output, which therefore needn't be kept. Every
+// codeword is a link to the codeword it extends along with the extending char.
+//
+// The pools are free to discard codewords that other codewords extend, so the
+// links go between nodes rather than codeword numbers. A node outlives its
+// codeword for as long as it is extended by some other node, so it's only the
+// dictionary contents and their prefixes that are held in memory.
+template <typename Pool>
+class PoolLinkDecodeDict final : public PoolDict<Pool> {
+public:
+    PoolLinkDecodeDict (int limit, bool single_char_codewords);
+
+    // Adds a new codeword, the extension of codeword `i` by `a`, unless the
+    // pool rejects it.
+    void add_extension (int i, char a);
+
+    // Same as above, but the extending char is not known yet and has to be
+    // provided with `set_extending_char()` before the new codeword is used.
+    // This is the case in LZW.
+    void add_extension (int i);
+
+    // Provides the extending char of the codeword added last by
+    // `add_extension(int)`. Does nothing if it has been rejected.
+    void set_extending_char (char a);
+
+    // Returns the length of the `i`th codeword.
+    int64_t length (int i) const;
+
+    // Returns the first char of the `i`th codeword, which has to be nonempty.
+    char first_char (int i) const;
+
+    // Writes the `i`th codeword to `length(i)` chars starting at `dest`.
+    void spell (int i, char* dest) const;
+
+    // Drops all codewords but the permanent ones, as if the dictionary were
+    // constructed anew.
+    void reset ();
+
+private:
+    struct Node {
+        int parent;
+        // Number of child nodes, plus one if the node is a codeword.
+        int ref_cnt;
+        int64_t length;
+        char last_char;
+        char first_char;
+    };
+
+    // All nodes, including the free ones. Node 0 is the empty codeword.
+    std::vector<Node> m_nodes;
+
+    // Indices of free elements of `m_nodes`.
+    std::vector<int> m_free_nodes;
+
+    // An array mapping codeword numbers to nodes. Unused numbers map to `-1`.
+    std::vector<int> m_codeword_nodes;
+
+    // The node whose extending char is yet to be set, or `-1`.
+    int m_pending_node;
+
+    // Implements both variants of `add_extension()`. Returns the new node, or
+    // `-1` if the pool rejected the codeword.
+    int extend (int i, char a);
+
+    // Creates a codeword node extending node `parent` by `a`.
+    int new_node (int parent, char a);
+
+    // Drops a reference to node `k`, freeing it and possibly its ancestors.
+    void release (int k);
+};
+
+template <typename Pool>
+PoolLinkDecodeDict<Pool>::PoolLinkDecodeDict (
+    int limit,
+    bool single_char_codewords
+) :
+    PoolDict<Pool>(limit, single_char_codewords),
+    m_codeword_nodes(limit + 1, -1)
+{
+    m_nodes.reserve(limit + 1);
+    reset();
+}
+
+template <typename Pool>
+void PoolLinkDecodeDict<Pool>::reset () {
+    PoolDict<Pool>::reset();
+    m_nodes.assign(1, Node{0, 1, 0, '\0', '\0'});
+    m_free_nodes.clear();
+    std::fill(m_codeword_nodes.begin(), m_codeword_nodes.end(), -1);
+    m_codeword_nodes[0] = 0;
+    m_pending_node = -1;
+    for (int a = 0; a < this->fixed_cnt(); ++a)
+        m_codeword_nodes[a + 1] = new_node(0, a);
+}
+
+template <typename Pool>
+inline void PoolLinkDecodeDict<Pool>::add_extension (int i, char a) {
+    extend(i, a);
+}
+
+template <typename Pool>
+inline void PoolLinkDecodeDict<Pool>::add_extension (int i) {
+    m_pending_node = extend(i, '\0');
+}
+
+template <typename Pool>
+inline void PoolLinkDecodeDict<Pool>::set_extending_char (char a) {
+    if (m_pending_node == -1)
+        return;
+    Node& node = m_nodes[m_pending_node];
+    node.last_char = a;
+    if (node.length == 1)
+        node.first_char = a;
+    m_pending_node = -1;
+}
+
+template <typename Pool>
+inline int64_t PoolLinkDecodeDict<Pool>::length (int i) const {
+    assert(0 <= i && i < m_codeword_nodes.size());
+    assert(m_codeword_nodes[i] != -1);
+    return m_nodes[m_codeword_nodes[i]].length;
+}
+
+template <typename Pool>
+inline char PoolLinkDecodeDict<Pool>::first_char (int i) const {
+    assert(length(i) > 0);
+    return m_nodes[m_codeword_nodes[i]].first_char;
+}
+
+template <typename Pool>
+inline void PoolLinkDecodeDict<Pool>::spell (int i, char* dest) const {
+    assert(m_codeword_nodes[i] != m_pending_node || m_pending_node == -1);
+    int k = m_codeword_nodes[i];
+    for (int64_t p = m_nodes[k].length - 1; p >= 0; --p) {
+        dest[p] = m_nodes[k].last_char;
+        k = m_nodes[k].parent;
+    }
+}
+
+template <typename Pool>
+int PoolLinkDecodeDict<Pool>::extend (int i, char a) {
+    assert(0 <= i && i < m_codeword_nodes.size());
+    assert(m_codeword_nodes[i] != -1);
+    int const parent = m_codeword_nodes[i];
+    int const j = this->match(i);
+    if (j == 0)
+        return -1;
+    // The new node refers to `parent` before the previous codeword `j` is
+    // released, so that `parent` survives even if it's that codeword.
+    int const k = new_node(parent, a);
+    if (m_codeword_nodes[j] != -1)
+        release(m_codeword_nodes[j]);
+    m_codeword_nodes[j] = k;
+    return k;
+}
+
+template <typename Pool>
+int PoolLinkDecodeDict<Pool>::new_node (int parent, char a) {
+    Node const& p = m_nodes[parent];
+    Node const node{
+        parent,
+        1,
+        p.length + 1,
+        a,
+        p.length == 0 ? a : p.first_char
+    };
+    ++m_nodes[parent].ref_cnt;
+    if (m_free_nodes.empty()) {
+        m_nodes.push_back(node);
+        return m_nodes.size() - 1;
+    }
+    int const k = m_free_nodes.back();
+    m_free_nodes.pop_back();
+    m_nodes[k] = node;
+    return k;
+}
+
+template <typename Pool>
+void PoolLinkDecodeDict<Pool>::release (int k) {
+    while (--m_nodes[k].ref_cnt == 0) {
+        assert(k != 0);
+        m_free_nodes.push_back(k);
+        k = m_nodes[k].parent;
+    }
+}
+
 // CodewordPool
 // =============================================================================
 // TODO doc
@@ -201,24 +549,31 @@ public:
 
     int limit () const;
 
+    // Returns the number of permanent codewords, i.e., `CHAR_CNT` if there are
+    // single char codewords and `0` otherwise.
+    int fixed_cnt () const;
+
     virtual int match (int i) = 0;
 
 private:
     int m_limit;
+    int m_fixed_cnt;
 };
 
 inline CodewordPool::CodewordPool (int limit, bool single_char_codewords) :
-    m_limit(limit)
+    m_limit(limit),
+    m_fixed_cnt(single_char_codewords ? CHAR_CNT : 0)
 {
     assert(limit > 0);
     assert(!single_char_codewords || limit > CHAR_CNT);
-    // Argument `single_char_codewords` is here only to bting to mind that
-    // such functionality has to be taken into account.
-    UNUSED(single_char_codewords);
 }
 
 inline int CodewordPool::limit () const {
     return m_limit;
 }
 
+inline int CodewordPool::fixed_cnt () const {
+    return m_fixed_cnt;
+}
+
 #endif // POOL_DICT_H
@@ -1,35 +1,58 @@
 #include "pool_dict_tree.h"
 
-#include <queue>
-
 // PoolDictTree
 // =============================================================================
 
-PoolDictTree::PoolDictTree (Buffer const& input) :
+int const PoolDictTree::SLAB_DOUBLING_CNT;
+
+PoolDictTree::PoolDictTree (BufferView const& input) :
     m_input(input),
-    m_root(new Node(true, 0, 0, 0)),
+    m_slab(0),
+    m_slab_node_cnt(0),
+    m_root(new_node(Tag(true, 0, 0, 0))),
     m_nodes(1, m_root)
 {
-    BufferCharWriter alphabet_writer(m_alphabet);
-    alphabet_writer.put('\0'); // Dummy char to make the indexing 1-based.
-    for (int a = 0; a < CHAR_CNT; ++a)
-        alphabet_writer.put(a);
+    BufferCharWriter text_writer(m_text);
+    for (int a = CHAR_CNT - 1; a >= 0; --a)
+        text_writer.put(a);
 }
 
-PoolDictTree::~PoolDictTree () {
-    // All nodes are allocated on heap.
-    std::queue<Node*> queue;
-    queue.push(m_root);
-    while (!queue.empty()) {
-        Node* node = queue.front();
-        queue.pop();
-        for (auto kv : *node)
-            queue.push(kv.second);
-        delete node;
+PoolDictTree::PoolDictTree (PoolDictTree const& tree) :
+    m_input(tree.m_input),
+    m_slab(0),
+    m_slab_node_cnt(0),
+    m_root(new_node(tree.m_root->tag)),
+    m_nodes(tree.m_nodes.size(), nullptr)
+{
+    BufferCharWriter(m_text).put(
+        BufferCharSlice(tree.m_text, 0, tree.m_text.size() / CHAR_BITS)
+    );
+
+    // Every node of `tree` is paired with its copy. The inactive ones have to
+    // be copied too, but they have no codeword number.
+    m_nodes[0] = m_root;
+    std::vector<pair<Node*, Node*>> stack(1, make_pair(tree.m_root, m_root));
+    while (!stack.empty()) {
+        Node* const src = stack.back().first;
+        Node* const dst = stack.back().second;
+        stack.pop_back();
+        for (auto kv : *src) {
+            Node* const child = new_node(kv.second->tag);
+            dst->link_child(kv.first, child);
+            if (child->tag.active)
+                m_nodes[child->tag.codeword_no] = child;
+            stack.push_back(make_pair(kv.second, child));
+        }
     }
 }
 
-void PoolDictTree::extend (int i, int begin, int j) {
+PoolDictTree::~PoolDictTree () {
+    destroy_nodes();
+    for (Node* slab : m_slabs)
+        ::operator delete(slab);
+}
+
+void PoolDictTree::extend (int i, int64_t begin, int j) {
     assert(0 <= i && i <  m_nodes.size());
     assert(0 <  j && j <= m_nodes.size());
 
@@ -46,7 +69,7 @@ void PoolDictTree::extend (int i, int begin, int j) {
     assert(upper->tag.active);
 
     // Length of the new codeword.
-    int const length = upper->tag.length + 1;
+    int64_t const length = upper->tag.length + 1;
 
     // This is rather wacky way of obtaining the linking character. Fixing this
     // would involve either passing it as an argument to this method or allowing
@@ -62,13 +85,13 @@ void PoolDictTree::extend (int i, int begin, int j) {
     if (lower == nullptr) {
         // There is no node hanging from `upper` along `a`, so we simply
         // attach one and we're done.
-        Node* fresh = new Node(true, j, begin, length);
+        Node* fresh = new_node(Tag(true, j, begin, length));
         upper->link_child(a, fresh);
         m_nodes[j] = fresh;
     } else if (lower->tag.length > length){
         // Node `lower` is an even greater extension of `upper`. The edge
         // between `upper` and `lower` has to be split.
-        Node* fresh = new Node(true, j, begin, length);
+        Node* fresh = new_node(Tag(true, j, begin, length));
         char b = slice(lower->tag.begin, length + 1)[length];
         // This order of relinking is important, because first `lower` has to
         // be detached from `upper`.
@@ -97,12 +120,74 @@ PoolDictTree::Edge PoolDictTree::edge (Node const* node, char a) const {
     if (child == nullptr) {
         return Edge();
     } else {
-        int begin = child->tag.begin + node->tag.length;
-        int length = child->tag.length - node->tag.length;
+        int64_t begin = child->tag.begin + node->tag.length;
+        int64_t length = child->tag.length - node->tag.length;
         return Edge(child, slice(begin, length));
     }
 }
 
+void PoolDictTree::compact (Buffer& text) {
+    assert(text.size() == 0);
+
+    std::vector<Node*> const order = nodes();
+
+    // Every leaf gets a copy of its whole codeword. Inner nodes are prefixes
+    // of their descendants, so they can refer to the text of any of them. It
+    // is the whole codewords rather than just edges that are retained, because
+    // `remove()` may merge an edge with the one above it.
+    BufferCharWriter writer(text);
+    int64_t pos = 0;
+    for (size_t k = order.size() - 1; k > 0; --k) {
+        Tag& tag = order[k]->tag;
+        // Single letter codewords refer to the alphabet, and codewords copied
+        // by `detach()` to the owned text.
+        if (tag.begin < 0)
+            continue;
+        if (order[k]->is_leaf()) {
+            writer.put(slice(tag.begin, tag.length));
+            tag.begin = pos;
+            pos += tag.length;
+        } else {
+            tag.begin = order[k]->begin()->second->tag.begin;
+        }
+    }
+}
+
+void PoolDictTree::clear () {
+    // The root is made anew in the same place, as the dictionaries hold on to
+    // it.
+    Tag const tag = m_root->tag;
+    destroy_nodes();
+    m_slab = 0;
+    m_slab_node_cnt = 0;
+    m_free_nodes.clear();
+    m_root = new_node(tag);
+    m_nodes.resize(1);
+    assert(m_nodes[0] == m_root);
+}
+
+void PoolDictTree::detach () {
+    Buffer text;
+    compact(text);
+
+    // The copied text goes in front of the owned text and the positions are
+    // moved by its new length, so that they stay the same from its beginning.
+    int64_t const text_cnt = text.size() / CHAR_BITS;
+    int64_t const owned_cnt = m_text.size() / CHAR_BITS;
+    BufferCharWriter(text).put(BufferCharSlice(m_text, 0, owned_cnt));
+    std::vector<Node*> const order = nodes();
+    for (size_t k = 1; k < order.size(); ++k) {
+        Tag& tag = order[k]->tag;
+        if (tag.begin >= 0)
+            tag.begin -= text_cnt + owned_cnt;
+    }
+    m_text.clear();
+    BufferCharWriter(m_text).put(
+        BufferCharSlice(text, 0, text_cnt + owned_cnt)
+    );
+    m_input = BufferView();
+}
+
 void PoolDictTree::remove (Node* node) {
     assert(node != nullptr);
     assert(node->tag.active);
@@ -111,7 +196,7 @@ void PoolDictTree::remove (Node* node) {
     if (node->is_leaf()) {
         Node* parent = node->parent();
         node->unlink();
-        delete node;
+        free_node(node);
         assert(parent->tag.active || parent->child_cnt() > 0);
         // Removing a leaf may yield an inactive node that has only one child.
         // In such case we have to shortcut it to its grandparent.
@@ -121,7 +206,7 @@ void PoolDictTree::remove (Node* node) {
             Node* grandparent = parent->parent();
             parent->unlink();
             grandparent->link_child(a, parent->begin()->second);
-            delete parent;
+            free_node(parent);
         }
     } else if (node->child_cnt() == 1) {
         // This node has only one child. That child has to be shortcut to its
@@ -131,15 +216,35 @@ void PoolDictTree::remove (Node* node) {
         Node* child = node->begin()->second;
         node->unlink();
         parent->link_child(a, child);
-        delete node;
+        free_node(node);
     } else {
         // We deal with a forking node. It suffices to just mark it as inactive.
         node->tag.active = false;
     }
 }
 
-inline BufferCharSlice PoolDictTree::slice (int begin, int length) const {
+void PoolDictTree::destroy_nodes () {
+    // The links are left dangling, which is fine as long as all the nodes go.
+    for (int k = 0; k <= m_slab; ++k) {
+        int const cnt = k < m_slab ? slab_node_cnt(k) : m_slab_node_cnt;
+        for (int i = 0; i < cnt; ++i)
+            m_slabs[k][i].~Node();
+    }
+}
+
+inline BufferCharSlice
+PoolDictTree::slice (int64_t begin, int64_t length) const {
+    assert(begin >= 0 || begin + length <= 0);
     return begin < 0
-        ? BufferCharSlice(m_alphabet, -begin, length)
+        ? BufferCharSlice(m_text, m_text.size() / CHAR_BITS + begin, length)
         : BufferCharSlice(m_input, begin, length);
 }
+
+std::vector<PoolDictTree::Node*> PoolDictTree::nodes () const {
+    std::vector<Node*> order(1, m_root);
+    for (size_t k = 0; k < order.size(); ++k) {
+        for (auto kv : *order[k])
+            order.push_back(kv.second);
+    }
+    return order;
+}
@@ -2,6 +2,8 @@
 #define POOL_DICT_TREE_H
 
 #include "prefix.h"
+#include <new>
+#include <vector>
 
 #include "buffer.h"
 #include "word_tree_node.h"
@@ -18,10 +20,10 @@ public:
     struct Tag {
         bool active;
         int codeword_no;
-        int begin;
-        int length;
+        int64_t begin;
+        int64_t length;
 
-        Tag (bool active, int codeword_no, int begin, int length);
+        Tag (bool active, int codeword_no, int64_t begin, int64_t length);
 
         friend bool operator == (Tag const& tag1, Tag const& tag2);
     };
@@ -36,9 +38,12 @@ public:
         
         Edge (Node const* dst, BufferCharSlice const& slice);
 
-        int length () const;
+        int64_t length () const;
 
-        char operator [] (int i) const;
+        char operator [] (int64_t i) const;
+
+        // Returns the number of leading chars of `text` along the edge.
+        int64_t match (BufferCharSlice const& text) const;
 
     private:
         BufferCharSlice m_slice;
@@ -50,7 +55,12 @@ public:
 
     // Constructs a new dictionary tree built upon given buffer, consisting only
     // of the root node.
-    PoolDictTree (Buffer const& input);
+    PoolDictTree (BufferView const& input);
+
+    // Constructs a deep copy of `tree`, attached to the same buffer.
+    PoolDictTree (PoolDictTree const& tree);
+
+    PoolDictTree& operator = (PoolDictTree const& tree) = delete;
 
     ~PoolDictTree ();
 
@@ -67,7 +77,7 @@ public:
     //     is allocated.
     //
     // That way a contiguous range of codeword numbers is always maintained.
-    void extend (int i, int begin, int j);
+    void extend (int i, int64_t begin, int j);
 
     // TODO doc
     Edge edge (Node const* node, char a) const;
@@ -75,16 +85,58 @@ public:
     // TODO doc
     Node const* root () const;
 
+    // Replaces the underlying buffer. Positions stored in the tree are kept as
+    // they are, so they have to be valid in `input` as well.
+    void attach (BufferView const& input);
+
+    // Copies the text of the codewords into `text`, which has to be empty, and
+    // renumbers the positions stored in the tree to point there. Only the
+    // leaves are copied, so `text` is never longer than the sum of their
+    // lengths, no matter how much input has been processed. The tree has to
+    // be attached to `text`, or to a buffer starting with it, afterwards.
+    void compact (Buffer& text);
+
+    // Removes all nodes but the root. The text owned by the tree and the
+    // memory of the nodes are kept.
+    void clear ();
+
+    // Copies the text of the codewords into the tree itself, like `compact()`
+    // does, so that the tree no longer refers to the underlying buffer. The
+    // codewords keep working with any input attached afterwards, which makes
+    // the tree usable as a preset dictionary.
+    void detach ();
+
 private:
+    // The number of nodes in the first slab. Each of the next
+    // `SLAB_DOUBLING_CNT` slabs is twice as large as the one before, the rest
+    // are as large as the last of them.
+    static int const MIN_SLAB_NODE_CNT = 64;
+    static int const SLAB_DOUBLING_CNT = 10;
 
     // The underlying buffer.
-    Buffer const& m_input;
+    BufferView m_input;
 
-    // A buffer consisting of all possible characters in order. Used to take
-    // slices from when providing egdges to single letter codewords, if present.
-    Buffer m_alphabet;
+    // Text owned by the tree, which behaves as if it preceded the underlying
+    // buffer, i.e., negative positions refer to it counting from its end. It
+    // ends with the whole alphabet in reverse order, so that single letter
+    // codeword `a` begins at position `-a - 1`. The text copied by `detach()`
+    // goes in front of it.
+    Buffer m_text;
 
-    // Root node.
+    // The nodes are allocated in slabs, filled one by one. Removed nodes stay
+    // constructed, unlinked and childless, and are recycled before the slabs
+    // are drawn from any further. The slabs are released at once, without
+    // walking the tree.
+    std::vector<Node*> m_slabs;
+
+    // The slab being filled and the number of nodes constructed within.
+    int m_slab;
+    int m_slab_node_cnt;
+
+    // Removed nodes.
+    std::vector<Node*> m_free_nodes;
+
+    // Root node, the very first one in the slabs.
     Node* m_root;
 
     // An array mapping codeword indices to tree nodes.
@@ -93,19 +145,71 @@ private:
     // Removes a node from the tree. Implicitly called by `extend()`.
     void remove (Node* node);
 
+    // Returns an unlinked node with given tag.
+    Node* new_node (Tag const& tag);
+
+    // Takes back `node`, which has to be unlinked and childless.
+    void free_node (Node* node);
+
+    // Destroys all nodes, keeping the slabs.
+    void destroy_nodes ();
+
+    // Returns the number of nodes in slab `k`.
+    static int slab_node_cnt (int k);
+
     // TODO doc
-    BufferCharSlice slice (int begin, int length) const;
+    BufferCharSlice slice (int64_t begin, int64_t length) const;
+
+    // Returns all nodes in breadth first order, so that children come after
+    // parents.
+    std::vector<Node*> nodes () const;
 };
 
+inline PoolDictTree::Node* PoolDictTree::new_node (Tag const& tag) {
+    if (!m_free_nodes.empty()) {
+        Node* const node = m_free_nodes.back();
+        m_free_nodes.pop_back();
+        node->tag = tag;
+        return node;
+    }
+    if (m_slab_node_cnt == slab_node_cnt(m_slab)) {
+        ++m_slab;
+        m_slab_node_cnt = 0;
+    }
+    if (m_slab == m_slabs.size()) {
+        m_slabs.push_back(static_cast<Node*>(
+            ::operator new(slab_node_cnt(m_slab) * sizeof(Node))
+        ));
+    }
+    return new (m_slabs[m_slab] + m_slab_node_cnt++) Node(tag);
+}
+
+inline void PoolDictTree::free_node (Node* node) {
+    assert(node->is_root() && node->is_leaf());
+    m_free_nodes.push_back(node);
+}
+
+inline int PoolDictTree::slab_node_cnt (int k) {
+    return MIN_SLAB_NODE_CNT << min(k, SLAB_DOUBLING_CNT);
+}
+
 inline PoolDictTree::Node const* PoolDictTree::root () const {
     return m_root;
 }
 
+inline void PoolDictTree::attach (BufferView const& input) {
+    m_input = input;
+}
+
 // PoolDictBase::Tag
 // =============================================================================
 
-inline
-PoolDictTree::Tag::Tag (bool active, int codeword_no, int begin, int length) :
+inline PoolDictTree::Tag::Tag (
+    bool active,
+    int codeword_no,
+    int64_t begin,
+    int64_t length
+) :
     active(active),
     codeword_no(codeword_no),
     begin(begin),
@@ -140,14 +244,18 @@ PoolDictTree::Edge::Edge (Node const* dst, BufferCharSlice const& slice) :
     assert(dst != nullptr);
 }
 
-inline int PoolDictTree::Edge::length () const {
+inline int64_t PoolDictTree::Edge::length () const {
     return m_slice.length();
 }
 
-inline char PoolDictTree::Edge::operator [] (int i) const {
+inline char PoolDictTree::Edge::operator [] (int64_t i) const {
     return m_slice[i];
 }
 
+inline int64_t PoolDictTree::Edge::match (BufferCharSlice const& text) const {
+    return common_prefix_length(m_slice, text);
+}
+
 inline bool operator == (
     PoolDictTree::Edge const& e1,
     PoolDictTree::Edge const& e2
@@ -13,20 +13,49 @@ using std::flush;
 using std::string;
 
 #include <cstdint>
-// TODO: Investigate 32 vs 64 bit
-typedef uint32_t word;
-int const WORD_BITS = 32;
 int const CHAR_BITS = 8;
-int const WORD_CHARS = WORD_BITS / CHAR_BITS;
 int const INT_BITS = 32; // Well...
-word const NULL_WORD = 0;
-word const ONES_MASK = ~NULL_WORD;
 int const CHAR_CNT = 256;
 
+// Properties of a storage word. Buffers can be backed by either 32 or 64 bit
+// unsigned words.
+template <typename Word>
+struct WordTraits {
+    static int const BITS = sizeof(Word) * CHAR_BITS;
+    static int const CHARS = sizeof(Word);
+    static Word const NULL_WORD = 0;
+    static Word const ONES_MASK = ~Word(0);
+};
+
+template <typename Word> int const WordTraits<Word>::BITS;
+template <typename Word> int const WordTraits<Word>::CHARS;
+template <typename Word> Word const WordTraits<Word>::NULL_WORD;
+template <typename Word> Word const WordTraits<Word>::ONES_MASK;
+
+// The word backing the default `Buffer`. Selected at build time with
+// `LZC_WORD_BITS`, 64 bits unless stated otherwise.
+#ifndef LZC_WORD_BITS
+#define LZC_WORD_BITS 64
+#endif
+
+#if LZC_WORD_BITS == 64
+typedef uint64_t word;
+#elif LZC_WORD_BITS == 32
+typedef uint32_t word;
+#else
+#error "LZC_WORD_BITS must be either 32 or 64"
+#endif
+
+int const WORD_BITS = WordTraits<word>::BITS;
+int const WORD_CHARS = WordTraits<word>::CHARS;
+word const NULL_WORD = WordTraits<word>::NULL_WORD;
+word const ONES_MASK = WordTraits<word>::ONES_MASK;
+
 #include <algorithm>
 using std::min;
 using std::max;
 using std::copy;
+using std::fill;
 using std::equal;
 
 #include <utility>
@@ -36,36 +65,39 @@ using std::make_pair;
 
 #include <chrono>
 using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
 using std::chrono::system_clock;
 using std::chrono::duration_cast;
 
 #define UNUSED(var) (void)(var)
 
-inline word lshift (word x, int n) {
-    if (n >= WORD_BITS)
-        return NULL_WORD;
+template <typename Word>
+inline Word lshift (Word x, int n) {
+    if (n >= WordTraits<Word>::BITS)
+        return Word(0);
     if (n < 0) {
-        if (n <= -WORD_BITS)
-            return NULL_WORD;
+        if (n <= -WordTraits<Word>::BITS)
+            return Word(0);
         return x >> (-n);
     }
     return x << n;
 }
 
-inline word rshift (word x, int n) {
-    if (n >= WORD_BITS)
-        return NULL_WORD;
+template <typename Word>
+inline Word rshift (Word x, int n) {
+    if (n >= WordTraits<Word>::BITS)
+        return Word(0);
     if (n < 0) {
-        if (n <= -WORD_BITS)
-            return NULL_WORD;
+        if (n <= -WordTraits<Word>::BITS)
+            return Word(0);
         return x << (-n);
     }
     return x >> n;
 }
 
-inline int ceil_log2 (int n) {
+inline int ceil_log2 (int64_t n) {
     int i = 0;
-    int p = 1;
+    int64_t p = 1;
     while (p < n) {
         ++i;
         p *= 2;
@@ -0,0 +1,167 @@
+#ifndef PRESET_DICT_H
+#define PRESET_DICT_H
+
+#include "prefix.h"
+
+#include "buffer.h"
+#include "decode_sink.h"
+#include "lz.h"
+
+// PresetDict
+// =============================================================================
+//
+// A trained starting state for the dictionaries of `Lz78` and `Lzw`. Short
+// inputs barely compress when the dictionary starts empty, so the dictionary
+// is first trained on a sample of similar data, and every encoding and
+// decoding starts where the training left off.
+//
+// The training runs once, when the preset is constructed. Both dictionaries
+// are then detached from the sample. Every call clones them, which costs time
+// proportional to the dictionary limit rather than to the sample size. On top
+// of the `EncodeDict` interface, the encode dictionaries have to provide:
+//
+//   * a copy constructor, which clones them between matches;
+//   * `attach(input, pos)`, which moves them over to the input;
+//   * `detach()`, which makes them own the text of their codewords.
+//
+// The decoding goes through the `LinkDecodeDict` of the dictionary pair, which
+// owns its text by design.
+//
+// A preset is saved as the sample encoded with the very `Lz` it is meant for.
+// It is loaded by training a new preset on the decoded sample:
+//
+//     PresetDict<Lzw<Smru>> preset(lz, lz.decode(saved));
+template <typename LzType>
+class PresetDict {
+public:
+    // Trains the dictionaries of `lz` on `sample`, which has to be char
+    // aligned. The configuration of `lz` is used all along, so it has to
+    // outlive the preset.
+    PresetDict (LzType const& lz, BufferView const& sample);
+
+    // Same as `Lz::encode(BufferView const&, Buffer&)`, but the dictionary
+    // starts trained.
+    void encode (BufferView const& input, Buffer& output) const;
+
+    // Same as `Lz::decode(BufferView const&, Buffer&)` for encodings produced
+    // by `encode()`.
+    void decode (BufferView const& output, Buffer& input) const;
+
+    // Same as `Lz::decode(BufferView const&, DecodeSink&)` for encodings
+    // produced by `encode()`.
+    void decode (BufferView const& output, DecodeSink& sink) const;
+
+    // Stores the preset in `output`, discarding its previous contents.
+    void save (Buffer& output) const;
+
+private:
+    typedef typename LzType::EncodeDict EncodeDict;
+    typedef typename LzType::LinkDecodeDict LinkDecodeDict;
+
+    // A sink discarding everything, used for the training.
+    class NullSink final : public DecodeSink {
+    public:
+        virtual void put (char const* data, int64_t char_cnt) {
+            UNUSED(data);
+            UNUSED(char_cnt);
+        }
+    };
+
+    // The encoder/decoder whose methods are used.
+    LzType const& m_lz;
+
+    // A copy of the sample, kept for `save()`.
+    Buffer m_sample;
+
+    // The trained encode dictionary.
+    EncodeDict m_encode_dict;
+
+    // The trained decode dictionary.
+    LinkDecodeDict m_decode_dict;
+};
+
+template <typename LzType>
+PresetDict<LzType>::PresetDict (LzType const& lz, BufferView const& sample) :
+    m_lz(lz),
+    m_encode_dict(
+        BufferView(),
+        lz.m_dictionary_limit,
+        LzType::SINGLE_CHAR_CODEWORDS
+    ),
+    m_decode_dict(lz.m_dictionary_limit, LzType::SINGLE_CHAR_CODEWORDS)
+{
+    int64_t const char_cnt = sample.size() / CHAR_BITS;
+    BufferCharWriter(m_sample).put(BufferCharSlice(sample, 0, char_cnt));
+    m_encode_dict.attach(m_sample, 0);
+
+    // The partial match at the end of the sample is left out, so that the
+    // dictionary is between matches once the training is over.
+    Buffer codewords;
+    BufferBitWriter writer(codewords);
+    m_lz.factorize(m_encode_dict, writer, false);
+    writer.flush();
+
+    // The decode dictionary goes through the same codewords.
+    NullSink sink;
+    SinkWriter sink_writer(sink);
+    BufferBitReader reader(codewords);
+    m_lz.unfactorize(m_decode_dict, reader, sink_writer);
+
+    // In LZW, the codeword added last is extended by the char following the
+    // last match, which the decoder would take from the next codeword. It is
+    // the first char of the part left out. In LZ78 nothing is pending and this
+    // has no effect.
+    if (!m_encode_dict.eob()) {
+        int64_t const pos = m_encode_dict.next_pos();
+        m_decode_dict.set_extending_char(BufferCharSlice(m_sample, pos, 1)[0]);
+    }
+
+    m_encode_dict.detach();
+}
+
+template <typename LzType>
+void PresetDict<LzType>::encode (
+    BufferView const& input,
+    Buffer& output
+) const {
+    EncodeDict dict(m_encode_dict);
+    dict.attach(input, 0);
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    output.clear();
+    output.reserve(m_lz.max_encoded_bits(char_cnt));
+    BufferBitWriter writer(output);
+    writer.put64(char_cnt);
+    m_lz.factorize(dict, writer, true);
+    writer.flush();
+}
+
+template <typename LzType>
+void PresetDict<LzType>::decode (
+    BufferView const& output,
+    Buffer& input
+) const {
+    input.clear();
+    input.reserve(BufferBitReader(output).get64() * CHAR_BITS);
+    BufferDecodeSink sink(input);
+    decode(output, sink);
+}
+
+template <typename LzType>
+void PresetDict<LzType>::decode (
+    BufferView const& output,
+    DecodeSink& sink
+) const {
+    LinkDecodeDict dict(m_decode_dict);
+    BufferBitReader reader(output);
+    // The decoded length is of no use here.
+    reader.get64();
+    SinkWriter writer(sink);
+    m_lz.unfactorize(dict, reader, writer);
+}
+
+template <typename LzType>
+void PresetDict<LzType>::save (Buffer& output) const {
+    m_lz.encode(m_sample, output);
+}
+
+#endif // PRESET_DICT_H
@@ -5,69 +5,102 @@
 
 SmruPool::SmruPool (int limit, bool single_char_codewords) :
     CodewordPool(limit, single_char_codewords),
-    m_size(0)
-{
     // The 0 index is reserved for the empty codeword.
-    m_parents.reserve(limit + 1);
-    m_queue_positions.reserve(limit + 1);
-    m_parents.push_back(0);
-    // Root is not subject to queueing.
-    m_queue_positions.push_back(m_queue.end());
+    m_parents(limit + 1, 0),
+    m_child_cnts(limit + 1, 0),
+    m_stamps(limit + 1, 0),
+    m_leaves(int64_t(1) << ceil_log2(int64_t(limit) + 2), 0),
+    m_time(0),
+    m_oldest(0),
+    m_size(fixed_cnt())
+{
+    /* Do nothing. */
+}
 
-    if (single_char_codewords) {
-        m_parents.resize(CHAR_CNT + 1, 0);
-        // Note that single char words are also not subject to queueing.
-        m_queue_positions.resize(CHAR_CNT + 1, m_queue.end());
-        m_size = CHAR_CNT;
+void SmruPool::reset () {
+    for (int k = fixed_cnt() + 1; k <= m_size; ++k) {
+        if (m_child_cnts[k] == 0)
+            remove_leaf(k);
     }
+    m_oldest = m_time;
+    m_size = fixed_cnt();
 }
 
 int SmruPool::match (int i) {
     assert(0 <= i && i <= m_size);
+    int const fixed_cnt = this->fixed_cnt();
 
     // If a codeword is used, its prefixes are considered used more recently.
-    // The traversal stops when a permanent codeword is reached.
-    for (int j = i; m_queue_positions[j] != m_queue.end(); j = m_parents[j]) {
-        m_queue.erase(m_queue_positions[j]);
-        m_queue.push_back(j);
-        m_queue_positions[j] = --m_queue.end();
+    // They get the stamp once they become leaves.
+    ++m_time;
+    if (i > fixed_cnt) {
+        if (m_child_cnts[i] == 0) {
+            remove_leaf(i);
+            m_stamps[i] = m_time;
+            add_leaf(i);
+        } else {
+            m_stamps[i] = m_time;
+        }
     }
 
     int j;
     if (m_size < limit()) {
         // We can use a fresh codeword.
         j = ++m_size;
-        m_queue.push_front(j);
-        m_parents.push_back(i);
-        m_queue_positions.push_back(m_queue.begin());
     } else {
-        // Utilize the least recently used codeword.
-        j = m_queue.front();
+        // Utilize the least recently used codeword. Don't permit codewords
+        // longer than the limit. Such situation is detected when the codeword
+        // to be discarded is the longest match itself.
+        j = oldest_leaf();
+        if (j == i)
+            return 0;
+        remove_leaf(j);
+        int const parent = m_parents[j];
+        if (parent > fixed_cnt) {
+            m_stamps[parent] = max(m_stamps[parent], m_stamps[j]);
+            if (--m_child_cnts[parent] == 0)
+                add_leaf(parent);
+        }
     }
 
-    // Don't permit codewords longer than the limit. Such situation is
-    // detected when the codeword to be discarded is the longest match
-    // itself.
-    if (i != j) {
-        m_queue.erase(m_queue_positions[j]);
-        if (i == 0) {
-            m_queue.push_back(j);
-            m_queue_positions[j] = --m_queue.end();
-        } else {
-            m_queue_positions[j] = m_queue.insert(m_queue_positions[i], j);
-        }
-        m_parents[j] = i;
-        return j;
-    } else {
-        return 0;
+    if (i > fixed_cnt && m_child_cnts[i]++ == 0)
+        remove_leaf(i);
+    m_parents[j] = i;
+    m_child_cnts[j] = 0;
+    m_stamps[j] = m_time;
+    add_leaf(j);
+    return j;
+}
+
+inline void SmruPool::add_leaf (int k) {
+    assert(m_stamps[k] - m_oldest < int64_t(m_leaves.size()));
+    int& leaf = m_leaves[m_stamps[k] & (m_leaves.size() - 1)];
+    assert(leaf == 0);
+    leaf = k;
+}
+
+inline void SmruPool::remove_leaf (int k) {
+    int& leaf = m_leaves[m_stamps[k] & (m_leaves.size() - 1)];
+    assert(leaf == k);
+    leaf = 0;
+}
+
+int SmruPool::oldest_leaf () {
+    // Leaves are only ever added with stamps past the oldest one, so the scan
+    // never goes back.
+    int64_t const mask = m_leaves.size() - 1;
+    while (m_leaves[m_oldest & mask] == 0) {
+        assert(m_oldest < m_time);
+        ++m_oldest;
     }
+    return m_leaves[m_oldest & mask];
 }
 
 // SmruEncodeDict
 // =============================================================================
 
 SmruEncodeDict::SmruEncodeDict(
-    Buffer const& input,
+    BufferView const& input,
     int limit,
     bool single_char_codewords
 ) :
@@ -91,28 +124,52 @@ SmruEncodeDict::SmruEncodeDict(
     m_match_length = 0;
 }
 
-Match SmruEncodeDict::try_char () {
-    char a = this->get_char();
-    Node* next_node = m_node->child(a);
-    if (next_node != nullptr) {
-        // Still matching. This is not necessarily a maximal match.
-        m_node = next_node;
-        ++m_match_length;
-        return Match();
-    } else {
-        // Maximal match found. New node has to be added.
-        int i = m_node->tag;
-        int j = this->match(i);
-        // Don't update the dictionary if the new codeword is too long. This
-        // is indicated with `j == 0`.
-        if (j != 0)
-            m_node->link_child(a, &m_nodes[j]);
-        int length = m_match_length;
-        // New search starts at root.
-        m_node = &m_nodes.front();
-        m_match_length = 0;
-        return Match(i, length, a);
+SmruEncodeDict::SmruEncodeDict (SmruEncodeDict const& dict) :
+    PoolDict<SmruPool>(dict),
+    EncodeDict(dict)
+{
+    assert(dict.m_node == &dict.m_nodes.front());
+
+    // The nodes point at each other, so the links are made anew between the
+    // copies.
+    m_nodes.reserve(dict.m_nodes.size());
+    for (Node const& node : dict.m_nodes)
+        m_nodes.emplace_back(node.tag);
+    for (size_t k = 1; k < dict.m_nodes.size(); ++k) {
+        Node& node = const_cast<Node&>(dict.m_nodes[k]);
+        if (node.is_root())
+            continue;
+        Node const* const parent = node.parent();
+        m_nodes[parent - &dict.m_nodes.front()].link_child(
+            node.link_char(),
+            &m_nodes[k]
+        );
     }
+
+    m_node = &m_nodes.front();
+    m_match_length = 0;
+}
+
+void SmruEncodeDict::reset () {
+    assert(m_node == &m_nodes.front());
+    PoolDict<SmruPool>::reset();
+    for (size_t k = this->fixed_cnt() + 1; k < m_nodes.size(); ++k)
+        m_nodes[k].unlink();
+}
+
+Match SmruEncodeDict::end_match (char a) {
+    // Maximal match found. New node has to be added.
+    int i = m_node->tag;
+    int j = this->match(i);
+    // Don't update the dictionary if the new codeword is too long. This is
+    // indicated with `j == 0`.
+    if (j != 0)
+        m_node->link_child(a, &m_nodes[j]);
+    int64_t length = m_match_length;
+    // New search starts at root.
+    m_node = &m_nodes.front();
+    m_match_length = 0;
+    return Match(i, length, a);
 }
 
 Match SmruEncodeDict::fail_char () {
@@ -121,3 +178,115 @@ Match SmruEncodeDict::fail_char () {
     m_node = &m_nodes.front();
     return Match(i, m_match_length, '\0'); // The extending char is irrelevant.
 }
+
+Match SmruEncodeDict::next_match (bool last) {
+    assert(m_node == &m_nodes.front());
+    BufferCharSlice const text = lookahead();
+    Node* node = m_node;
+    int64_t length = 0;
+    while (length != text.length()) {
+        char a = text[length];
+        Node* next_node = node->child(a);
+        if (next_node == nullptr) {
+            int i = node->tag;
+            int j = this->match(i);
+            if (j != 0)
+                node->link_child(a, &m_nodes[j]);
+            skip(length);
+            return Match(i, length, a);
+        }
+        node = next_node;
+        ++length;
+    }
+    if (!last)
+        return Match();
+    skip(length);
+    return Match(node->tag, length, '\0'); // The extending char is irrelevant.
+}
+
+// FlatSmruEncodeDict
+// =============================================================================
+
+FlatSmruEncodeDict::FlatSmruEncodeDict (
+    BufferView const& input,
+    int limit,
+    bool single_char_codewords
+) :
+    PoolDict<SmruPool>(limit, single_char_codewords),
+    EncodeDict(input),
+    // Sized for the codewords, the table is at most half full.
+    m_edges(ceil_log2(2 * int64_t(limit) + 2)),
+    m_codeword_no(0),
+    m_match_length(0)
+{
+    // The codeword numbers must leave room for the label within a key, and
+    // for `NO_KEY`.
+    assert(limit < (1 << (32 - CHAR_BITS)) - 1);
+    m_keys.resize(limit + 1);
+    reset();
+}
+
+void FlatSmruEncodeDict::reset () {
+    assert(m_codeword_no == 0);
+    PoolDict<SmruPool>::reset();
+    m_edges.clear();
+    std::fill(m_keys.begin(), m_keys.end(), Edges::NO_KEY);
+    for (int a = 0; a < this->fixed_cnt(); ++a)
+        link(0, a, a + 1);
+}
+
+Match FlatSmruEncodeDict::end_match (char a) {
+    // Maximal match found. New codeword has to be added, unless it is too
+    // long, which is indicated with `j == 0`.
+    int i = m_codeword_no;
+    int j = this->match(i);
+    if (j != 0)
+        link(i, a, j);
+    int64_t length = m_match_length;
+    // New search starts at root.
+    m_codeword_no = 0;
+    m_match_length = 0;
+    return Match(i, length, a);
+}
+
+Match FlatSmruEncodeDict::fail_char () {
+    int i = m_codeword_no;
+    int64_t length = m_match_length;
+    // New search starts at root.
+    m_codeword_no = 0;
+    m_match_length = 0;
+    return Match(i, length, '\0'); // The extending char is irrelevant.
+}
+
+Match FlatSmruEncodeDict::next_match (bool last) {
+    assert(m_codeword_no == 0);
+    BufferCharSlice const text = lookahead();
+    int i = 0;
+    int64_t length = 0;
+    while (length != text.length()) {
+        char a = text[length];
+        Edges::Slot const& slot = m_edges[find(i, a)];
+        if (slot.key == Edges::NO_KEY) {
+            int j = this->match(i);
+            if (j != 0)
+                link(i, a, j);
+            skip(length);
+            return Match(i, length, a);
+        }
+        i = slot.value;
+        ++length;
+    }
+    if (!last)
+        return Match();
+    skip(length);
+    return Match(i, length, '\0'); // The extending char is irrelevant.
+}
+
+void FlatSmruEncodeDict::link (int i, char a, int j) {
+    // The discarded codeword is a leaf, so unlinking it leaves no orphans.
+    if (m_keys[j] != Edges::NO_KEY)
+        m_edges.remove(m_edges.find(m_keys[j]));
+    uint32_t const key = Edges::key(i, a);
+    m_edges.insert(m_edges.find(key), key, j);
+    m_keys[j] = key;
+}
@@ -2,10 +2,10 @@
 #define SMRU_DICT_H
 
 #include "prefix.h"
-#include <list>
 #include <vector>
 
 #include "dict.h"
+#include "edge_table.h"
 #include "pool_dict.h"
 #include "word_tree_node.h"
 
@@ -27,18 +27,32 @@
 // Such approach enables us to store the codewords in a trie, which grants
 // efficient storage, match lookup and the overall linear time of the LZ
 // encoding.
-class SmruPool : public CodewordPool {
+//
+// The codewords are ordered by the time of use, a prefix counting as used
+// right after its extensions. Since a prefix is always more recent than its
+// extensions, only the order of the leaves matters. So, instead of bringing
+// all prefixes to the back of a queue, only the codeword in use is stamped
+// with the time, and a prefix takes over the stamp of its discarded extension
+// once it becomes a leaf. The leaves are kept in buckets by their stamps, no
+// two of them sharing one. This takes constant time per match, amortized over
+// the scans for the oldest leaf.
+class SmruPool final : public CodewordPool {
 public:
     // Creates a pool with given limit. The limits is the upper bound for
     // both, the number of codewords and the length of a single codeword.
     SmruPool (int limit, bool single_char_codewords);
 
+    SmruPool& operator = (SmruPool const& pool) = delete;
+
+    // Drops all codewords but the permanent ones.
+    void reset ();
+
     // Implements `CodewordPool::match(int)`.
     //
     // This method handles the situation when the longest matching codeword is
     // found. It takes the number `i` of the longest matching codeword. Then it
-    // moves `i` and all of it's prefixes to the back of the discard queue and
-    // returns the number of the new codeword, which is the extension of `i`.
+    // marks `i` and all of it's prefixes as the most recently used and returns
+    // the number of the new codeword, which is the extension of `i`.
     //
     // If the number of codewords would exceed the limit, the new codeword
     // receives the number of the least recently used codeword, which gets
@@ -49,36 +63,82 @@ public:
     int match (int i);
 
 private:
-    // The discard queue. The elements are ordered with respect to time of use,
-    // the least recently used codewords being in the front.
-    std::list<int> m_queue;
-
     // The indices of codeword parents.
     std::vector<int> m_parents;
 
-    // The positions of codewords within the discard queue.
-    std::vector<std::list<int>::iterator> m_queue_positions;
+    // The numbers of codeword extensions.
+    std::vector<int> m_child_cnts;
+
+    // The time stamps of the codewords. The stamp of a leaf is the last time
+    // it or any of its former extensions was used. Those of the other
+    // codewords may be out of date. The permanent codewords are not stamped.
+    std::vector<int64_t> m_stamps;
+
+    // The leaf buckets, indexed by stamps modulo the size, which is a power of
+    // two. Empty buckets hold `0`. The stamps of the leaves lie within
+    // `limit() + 1` from each other, so that they never share a bucket.
+    std::vector<int> m_leaves;
+
+    // The current time, advanced by every match.
+    int64_t m_time;
+
+    // No leaf is older than this.
+    int64_t m_oldest;
 
     // The number of codewords stored in the dictionary.
     int m_size;
+
+    // Adds and removes leaf `k` to and from its bucket.
+    void add_leaf (int k);
+    void remove_leaf (int k);
+
+    // Returns the least recently used leaf.
+    int oldest_leaf ();
 };
 
 // SmruEncodeDict
 // =============================================================================
 //
 // The SMRU dictionary specialized for **encoding**.
-class SmruEncodeDict : public PoolDict<SmruPool>, public EncodeDict {
+class SmruEncodeDict final : public PoolDict<SmruPool>, public EncodeDict {
 public:
     // Constructs a dictionary with given limit.
-    SmruEncodeDict (Buffer const& input, int limit, bool single_char_codewords);
+    SmruEncodeDict (
+        BufferView const& input,
+        int limit,
+        bool single_char_codewords
+    );
 
     // Implements `EncodeDict::try_char(char)`. If the resulting new codeword
     // would exceed the maximal length, it is rejected.
+    //
+    // Only the rare case of a maximal match is handled out of line, so that
+    // the per-char work inlines into the encoding loop.
     virtual Match try_char ();
 
     // Implements `EncodeDict::fail_char()`.
     virtual Match fail_char ();
 
+    // Implements `EncodeDict::next_match()`.
+    virtual Match next_match (bool last);
+
+    // Constructs a copy of `dict` with its own trie. The dictionary has to be
+    // between matches.
+    SmruEncodeDict (SmruEncodeDict const& dict);
+
+    SmruEncodeDict& operator = (SmruEncodeDict const& dict) = delete;
+
+    // The trie doesn't refer to the input, so there is nothing to copy and
+    // `text` is left empty.
+    void compact (Buffer& text) const;
+
+    // The trie doesn't refer to the input, so this does nothing.
+    void detach ();
+
+    // Drops all codewords but the permanent ones, as if the dictionary were
+    // constructed anew. The position within the input is kept.
+    void reset ();
+
 private:
     // TODO doc
     typedef WordTreeNode<int> Node;
@@ -91,20 +151,153 @@ private:
     Node* m_node;
 
     // The length of the current longest match.
-    int m_match_length;
+    int64_t m_match_length;
+
+    // Handles the maximal match ending at the current node, which cannot be
+    // extended with `a`.
+    Match end_match (char a);
+};
+
+inline Match SmruEncodeDict::try_char () {
+    char a = this->get_char();
+    Node* next_node = m_node->child(a);
+    if (next_node == nullptr)
+        return end_match(a);
+    // Still matching. This is not necessarily a maximal match.
+    m_node = next_node;
+    ++m_match_length;
+    return Match();
+}
+
+inline void SmruEncodeDict::compact (Buffer& text) const {
+    UNUSED(text);
+}
+
+inline void SmruEncodeDict::detach () {
+    /* Do nothing. */
+}
+
+// FlatSmruEncodeDict
+// =============================================================================
+//
+// The SMRU dictionary specialized for **encoding**, with the whole trie in two
+// flat arrays rather than in linked nodes.
+//
+// Since SMRU discards leaves only, the trie nodes never outlive their
+// codewords, and the codeword numbers serve as node indices. The edges are
+// kept in an `EdgeTable` with 32-bit keys, mapping the parent codeword number
+// and the label to the child codeword number. An entry takes 8 bytes, so that
+// a lookup usually costs a single cache line. The table is allocated for the
+// limit up front, so it never grows. The other array maps every codeword to
+// the key of its edge, which is what a discarded codeword needs to be
+// unlinked.
+//
+// The encodings are the same as with `SmruEncodeDict`.
+class FlatSmruEncodeDict final : public PoolDict<SmruPool>, public EncodeDict {
+public:
+    // Constructs a dictionary with given limit, which has to be less than
+    // `2^24 - 1`.
+    FlatSmruEncodeDict (
+        BufferView const& input,
+        int limit,
+        bool single_char_codewords
+    );
+
+    // Implements `EncodeDict::try_char(char)`. If the resulting new codeword
+    // would exceed the maximal length, it is rejected.
+    virtual Match try_char ();
+
+    // Implements `EncodeDict::fail_char()`.
+    virtual Match fail_char ();
+
+    // Implements `EncodeDict::next_match()`.
+    virtual Match next_match (bool last);
+
+    // Constructs a copy of `dict`. The dictionary has to be between matches.
+    FlatSmruEncodeDict (FlatSmruEncodeDict const& dict) = default;
+
+    FlatSmruEncodeDict& operator = (FlatSmruEncodeDict const& dict) = delete;
+
+    // Leaves `text` empty, like `SmruEncodeDict::compact()`.
+    void compact (Buffer& text) const;
+
+    // Does nothing, like `SmruEncodeDict::detach()`.
+    void detach ();
+
+    // Drops all codewords but the permanent ones, as if the dictionary were
+    // constructed anew. The position within the input is kept.
+    void reset ();
+
+private:
+    // The edges of the trie, each leading to a child codeword number.
+    typedef EdgeTable<uint32_t, int> Edges;
+
+    Edges m_edges;
+
+    // The keys of the edges leading to the codewords, by codeword number.
+    // Codewords that aren't linked have `Edges::NO_KEY`.
+    std::vector<uint32_t> m_keys;
+
+    // The current state of the automaton, i.e., the longest match, and its
+    // length.
+    int m_codeword_no;
+    int64_t m_match_length;
+
+    // Returns the slot holding the edge from codeword `i` labelled `a`, or
+    // the free slot where it belongs.
+    int find (int i, char a) const;
+
+    // Makes codeword `j` the extension of `i` by `a`, unlinking it first if
+    // it has been in use.
+    void link (int i, char a, int j);
+
+    // Handles the maximal match ending at the current codeword, which cannot
+    // be extended with `a`.
+    Match end_match (char a);
 };
 
+inline Match FlatSmruEncodeDict::try_char () {
+    char a = this->get_char();
+    Edges::Slot const& slot = m_edges[find(m_codeword_no, a)];
+    if (slot.key == Edges::NO_KEY)
+        return end_match(a);
+    // Still matching. This is not necessarily a maximal match.
+    m_codeword_no = slot.value;
+    ++m_match_length;
+    return Match();
+}
+
+inline void FlatSmruEncodeDict::compact (Buffer& text) const {
+    UNUSED(text);
+}
+
+inline void FlatSmruEncodeDict::detach () {
+    /* Do nothing. */
+}
+
+inline int FlatSmruEncodeDict::find (int i, char a) const {
+    return m_edges.find(Edges::key(i, a));
+}
+
 // Smru
 // =============================================================================
 
 struct Smru {
     typedef SmruEncodeDict EncodeDict;
     typedef PoolDecodeDict<SmruPool> DecodeDict;
+    typedef PoolLinkDecodeDict<SmruPool> LinkDecodeDict;
 };
 
 struct Smru2 {
     typedef PoolEncodeDict<SmruPool> EncodeDict;
     typedef PoolDecodeDict<SmruPool> DecodeDict;
+    typedef PoolLinkDecodeDict<SmruPool> LinkDecodeDict;
+};
+
+struct FlatSmru {
+    typedef FlatSmruEncodeDict EncodeDict;
+    typedef PoolDecodeDict<SmruPool> DecodeDict;
+    typedef PoolLinkDecodeDict<SmruPool> LinkDecodeDict;
 };
 
 #endif // SMRU_DICT_H
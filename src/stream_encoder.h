@@ -0,0 +1,208 @@
+#ifndef STREAM_ENCODER_H
+#define STREAM_ENCODER_H
+
+#include "prefix.h"
+#include <memory>
+
+#include "buffer.h"
+#include "lz.h"
+
+// StreamEncoder
+// =============================================================================
+//
+// Push style counterpart of `Lz::encode()` for `Lz78` and `Lzw`. The input is
+// fed in chunks of arbitrary size and the encoding is appended to the output
+// as soon as it becomes known. The dictionary lives across the chunks, so the
+// codewords are exactly the same as if the whole input were encoded at once.
+// The decoder makes no difference between the two.
+//
+// The encoder keeps a window of input, which consists of the text the
+// dictionary refers to followed by the partial match that may still go on in
+// the next chunk. Once enough input has been consumed, the window is compacted
+// by `EncodeDict::compact()`, so the memory used is bounded by the size of the
+// dictionary rather than the size of the input. On top of the `EncodeDict`
+// interface, the dictionaries have to provide:
+//
+//   * `attach(input, pos)`, which moves them over to a new window;
+//   * `compact(text)`, which copies the text they refer to into the empty
+//     buffer `text` and renumbers their positions accordingly.
+template <typename LzType>
+class StreamEncoder {
+public:
+    // Constructs an encoder using the configuration of `lz`, which has to
+    // outlive it.
+    explicit StreamEncoder (LzType const& lz);
+
+    // Starts a new encoding and appends its header to `output`. An encoding in
+    // progress, if any, is abandoned.
+    void begin (Buffer& output);
+
+    // Encodes the `chunk` of input, which has to be char aligned, and appends
+    // the result to `output`. Only whole words are appended, the remaining bits
+    // are held back until the next call. It's fine to pass a different
+    // `output` on every call and concatenate them afterwards.
+    void feed (BufferView const& chunk, Buffer& output);
+
+    // Encodes what has been held back and appends it to `output`, which
+    // completes the encoding.
+    void finish (Buffer& output);
+
+    // Returns the number of input chars currently retained by the encoder.
+    int64_t retained () const;
+
+private:
+    typedef typename LzType::EncodeDict EncodeDict;
+
+    // Consumed input chars that trigger the compaction of the window, unless
+    // it's the compacted text that prevails.
+    static int64_t const COMPACTION_THRESHOLD = 1 << 16;
+
+    // The encoder/decoder whose `factorize()` method is used.
+    LzType const& m_lz;
+
+    // The dictionary of the current encoding.
+    std::unique_ptr<EncodeDict> m_dict;
+
+    // Two buffers which take turns at being the input window. The other one
+    // is the destination of compaction.
+    Buffer m_windows[2];
+
+    // Index of the current window within `m_windows`.
+    int m_window;
+
+    // Number of chars at the beginning of the window that are the compacted
+    // text of the dictionary rather than fresh input.
+    int64_t m_compacted_cnt;
+
+    // Scratch buffer the codewords are written to.
+    Buffer m_codewords;
+
+    // The bits of the encoding that haven't made a whole word yet.
+    word m_pending;
+    int m_pending_cnt;
+
+    // Appends the chunk to the window and encodes it.
+    void encode (BufferView const& chunk, bool last);
+
+    // Appends all whole words of `m_codewords` to `output` and keeps the rest
+    // pending.
+    void emit (Buffer& output);
+
+    // Copies the text referred to by the dictionary and the trailing partial
+    // match to the other window and switches over to it.
+    void compact ();
+};
+
+template <typename LzType>
+int64_t const StreamEncoder<LzType>::COMPACTION_THRESHOLD;
+
+template <typename LzType>
+StreamEncoder<LzType>::StreamEncoder (LzType const& lz) :
+    m_lz(lz),
+    m_window(0),
+    m_compacted_cnt(0),
+    m_pending(0),
+    m_pending_cnt(0)
+{
+    /* Do nothing. */
+}
+
+template <typename LzType>
+void StreamEncoder<LzType>::begin (Buffer& output) {
+    m_window = 0;
+    m_windows[0].clear();
+    m_windows[1].clear();
+    m_compacted_cnt = 0;
+    m_dict.reset(new EncodeDict(
+        m_windows[0],
+        m_lz.m_dictionary_limit,
+        LzType::SINGLE_CHAR_CODEWORDS
+    ));
+    m_codewords.clear();
+    BufferBitWriter writer(m_codewords);
+    writer.put64(0);
+    writer.flush();
+    m_pending_cnt = 0;
+    emit(output);
+}
+
+template <typename LzType>
+inline void StreamEncoder<LzType>::feed (
+    BufferView const& chunk,
+    Buffer& output
+) {
+    encode(chunk, false);
+    emit(output);
+}
+
+template <typename LzType>
+void StreamEncoder<LzType>::finish (Buffer& output) {
+    encode(BufferView(), true);
+    emit(output);
+    BufferBitWriter writer(output);
+    writer.put(m_pending, m_pending_cnt);
+    writer.flush();
+    m_pending_cnt = 0;
+    m_dict.reset();
+}
+
+template <typename LzType>
+inline int64_t StreamEncoder<LzType>::retained () const {
+    return m_windows[m_window].size() / CHAR_BITS;
+}
+
+template <typename LzType>
+void StreamEncoder<LzType>::encode (BufferView const& chunk, bool last) {
+    assert(m_dict != nullptr);
+    assert(chunk.is_char_aligned());
+
+    Buffer& window = m_windows[m_window];
+    int64_t const pos = m_dict->next_pos();
+    BufferCharWriter(window).put(
+        BufferCharSlice(chunk, 0, chunk.size() / CHAR_BITS)
+    );
+    // The window may have been reallocated.
+    m_dict->attach(window, pos);
+
+    m_codewords.clear();
+    BufferBitWriter writer(m_codewords);
+    writer.put(m_pending, m_pending_cnt);
+    m_lz.factorize(*m_dict, writer, last);
+    writer.flush();
+
+    // Compacting every time the consumed input outgrows the compacted text
+    // keeps the amortized cost linear.
+    int64_t const consumed_cnt = m_dict->next_pos() - m_compacted_cnt;
+    if (!last && consumed_cnt >= max(COMPACTION_THRESHOLD, m_compacted_cnt))
+        compact();
+}
+
+template <typename LzType>
+void StreamEncoder<LzType>::emit (Buffer& output) {
+    BufferBitReader reader(m_codewords);
+    BufferBitWriter writer(output);
+    while (reader.left() >= WORD_BITS)
+        writer.put(reader.get(WORD_BITS), WORD_BITS);
+    writer.flush();
+    m_pending_cnt = reader.left();
+    m_pending = reader.get(m_pending_cnt);
+}
+
+template <typename LzType>
+void StreamEncoder<LzType>::compact () {
+    Buffer& window = m_windows[m_window];
+    Buffer& compacted = m_windows[1 - m_window];
+    int64_t const pos = m_dict->next_pos();
+
+    compacted.clear();
+    m_dict->compact(compacted);
+    m_compacted_cnt = compacted.size() / CHAR_BITS;
+    int64_t const tail_cnt = window.size() / CHAR_BITS - pos;
+    BufferCharWriter(compacted).put(BufferCharSlice(window, pos, tail_cnt));
+
+    m_window = 1 - m_window;
+    m_dict->attach(compacted, m_compacted_cnt);
+    window.clear();
+}
+
+#endif // STREAM_ENCODER_H
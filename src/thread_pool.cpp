@@ -0,0 +1,94 @@
+#include "thread_pool.h"
+
+// ThreadPool
+// =============================================================================
+
+ThreadPool::ThreadPool (int worker_cnt) :
+    m_task(nullptr),
+    m_task_cnt(0),
+    m_next_task(0),
+    m_done_cnt(0),
+    m_active_cnt(0),
+    m_generation(0),
+    m_stop(false)
+{
+    assert(worker_cnt >= 0);
+    m_workers.reserve(worker_cnt);
+    for (int i = 0; i < worker_cnt; ++i)
+        m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool () {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::run (
+    int64_t task_cnt,
+    std::function<void (int64_t)> const& task
+) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(m_active_cnt == 0);
+        m_task = &task;
+        m_task_cnt = task_cnt;
+        m_next_task = 0;
+        m_done_cnt = 0;
+        ++m_generation;
+    }
+    m_start.notify_all();
+
+    int64_t const done_cnt = run_tasks();
+
+    // Workers that are late to the loop find no tasks left, but they have to
+    // be waited for all the same, as they refer to `task`.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cnt += done_cnt;
+    m_finish.wait(lock, [this] () {
+        return m_done_cnt == m_task_cnt && m_active_cnt == 0;
+    });
+    m_task = nullptr;
+}
+
+int ThreadPool::default_worker_cnt () {
+    return max(0, int(std::thread::hardware_concurrency()) - 1);
+}
+
+void ThreadPool::work () {
+    int64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, generation] () {
+                return m_stop || (m_generation != generation && m_task);
+            });
+            if (m_stop)
+                return;
+            generation = m_generation;
+            ++m_active_cnt;
+        }
+
+        int64_t const done_cnt = run_tasks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done_cnt += done_cnt;
+            --m_active_cnt;
+        }
+        m_finish.notify_all();
+    }
+}
+
+int64_t ThreadPool::run_tasks () {
+    int64_t done_cnt = 0;
+    for (int64_t i = m_next_task++; i < m_task_cnt; i = m_next_task++) {
+        (*m_task)(i);
+        ++done_cnt;
+    }
+    return done_cnt;
+}
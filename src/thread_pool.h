@@ -0,0 +1,82 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "prefix.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool
+// =============================================================================
+//
+// A fixed set of worker threads running parallel loops. The calling thread
+// takes part in every loop as well, so a pool with no workers runs everything
+// inline.
+class ThreadPool {
+public:
+    // Starts `worker_cnt` worker threads. By default, there is one worker per
+    // hardware thread other than the calling one.
+    explicit ThreadPool (int worker_cnt = default_worker_cnt());
+
+    // Stops and joins the workers.
+    ~ThreadPool ();
+
+    // Returns the number of threads taking part in a loop, i.e., the number
+    // of workers plus one.
+    int thread_cnt () const;
+
+    // Calls `task(i)` for every `i` from `0` to `task_cnt - 1` and returns once
+    // all the calls have returned. The calls are spread among the threads in
+    // no particular order.
+    void run (int64_t task_cnt, std::function<void (int64_t)> const& task);
+
+    // Returns the number of hardware threads minus one, but at least zero.
+    static int default_worker_cnt ();
+
+private:
+    std::vector<std::thread> m_workers;
+
+    // Guards everything below but `m_next_task`.
+    std::mutex m_mutex;
+
+    // Signalled when a loop starts or the pool is being destroyed.
+    std::condition_variable m_start;
+
+    // Signalled when a worker is done with a loop.
+    std::condition_variable m_finish;
+
+    // The loop in progress.
+    std::function<void (int64_t)> const* m_task;
+    int64_t m_task_cnt;
+
+    // Index of the next call of `m_task` to be made.
+    std::atomic<int64_t> m_next_task;
+
+    // Number of calls of `m_task` that have returned.
+    int64_t m_done_cnt;
+
+    // Number of workers taking part in the loop in progress.
+    int m_active_cnt;
+
+    // Incremented with every loop, so that workers can tell a new one.
+    int64_t m_generation;
+
+    // Set when the pool is being destroyed.
+    bool m_stop;
+
+    // The body of a worker thread.
+    void work ();
+
+    // Makes calls of `m_task` until there are none left and returns their
+    // number.
+    int64_t run_tasks ();
+};
+
+inline int ThreadPool::thread_cnt () const {
+    return m_workers.size() + 1;
+}
+
+#endif // THREAD_POOL_H
@@ -2,25 +2,29 @@
 #define WMRU_DICT
 
 #include "prefix.h"
-#include <list>
-#include <vector>
 
+#include "index_queue.h"
 #include "pool_dict.h"
 
 // WmruPool
 // =============================================================================
 //
 // TODO doc
-class WmruPool : public CodewordPool {
+class WmruPool final : public CodewordPool {
 public:
     WmruPool (int limit, bool single_char_codewords);
 
+    WmruPool& operator = (WmruPool const& pool) = delete;
+
+    // Drops all codewords but the permanent ones.
+    void reset ();
+
     int match (int i);
 
 private:
-    std::list<int> m_queue;
-
-    std::vector<std::list<int>::iterator> m_queue_positions;
+    // The discard queue, the least recently used codewords being in the
+    // front. The permanent codewords are not subject to queueing.
+    IndexQueue m_queue;
 
     int m_size;
 };
@@ -31,6 +35,7 @@ private:
 struct Wmru {
     typedef PoolEncodeDict<WmruPool> EncodeDict;
     typedef PoolDecodeDict<WmruPool> DecodeDict;
+    typedef PoolLinkDecodeDict<WmruPool> LinkDecodeDict;
 };
 
 #endif // WMRU_DICT
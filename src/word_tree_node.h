@@ -2,20 +2,29 @@
 #define WORD_TREE_NODE_H
 
 #include "prefix.h"
-
-#include <unordered_map>
+#include <cstring>
+#include <new>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // WordTreeNode
 // =============================================================================
 //
 // A node of a word tree with vertices holding information of type `T`.
 //
-// TODO
+// The children are kept in one of three representations, depending on their
+// number. Up to `SMALL_CNT` of them are stored inline in a sorted array. Up to
+// `MEDIUM_CNT` of them go to a sorted array on the heap. Beyond that, a bitmap
+// of the edge labels selects from a dense array of children, ordered by the
+// labels too. The array is allocated along with the bitmap and grows by
+// doubling. The representation changes back only once the number of
+// children drops well below the bound, so that a node gaining and losing
+// a child in turns doesn't reallocate every time.
 template <typename T>
 class WordTreeNode {
 public:
-    typedef std::unordered_map<char, WordTreeNode*> ChildMap;
-    typedef typename ChildMap::iterator iterator;
+    class iterator;
 
     T tag;
 
@@ -24,6 +33,17 @@ public:
     template <typename... Args>
     explicit WordTreeNode (Args const&... label_args);
 
+    // Takes over the children of `node`, which are left pointing at it as
+    // their parent. Only meant for storing nodes in a vector, which is
+    // reserved before they are linked.
+    WordTreeNode (WordTreeNode&& node);
+
+    WordTreeNode (WordTreeNode const& node) = delete;
+
+    WordTreeNode& operator = (WordTreeNode const& node) = delete;
+
+    ~WordTreeNode ();
+
     // Returns the parent node. The result is `nullptr` in case of root.
     WordTreeNode* parent ();
 
@@ -31,7 +51,8 @@ public:
     // such edge exists.
     WordTreeNode* child (char a);
 
-    // Returns the iterator pointing to the first child.
+    // Returns the iterator pointing to the first child. The children are
+    // ordered by the labels of their edges, compared as unsigned chars.
     iterator begin ();
 
     // Returns the iterator pointing right past the last child.
@@ -57,27 +78,158 @@ public:
     // Returns `true` if the node is a leaf, i.e., has no children.
     bool is_leaf () const;
 
+    // Returns the number of heap bytes taken by the children, on top of
+    // `sizeof(WordTreeNode)`.
+    int64_t child_bytes () const;
+
 private:
+    // The bounds on the number of children in the inline and the heap array.
+    static int const SMALL_CNT = 4;
+    static int const MEDIUM_CNT = 16;
+
+    enum Kind : uint8_t {
+        SMALL,
+        MEDIUM,
+        LARGE
+    };
+
+    struct Small {
+        uint8_t labels[SMALL_CNT];
+        WordTreeNode* children[SMALL_CNT];
+    };
+
+    struct Medium {
+        uint8_t labels[MEDIUM_CNT];
+        WordTreeNode* children[MEDIUM_CNT];
+    };
+
+    // The header of the large representation. The children follow it in the
+    // same allocation, one per set bit.
+    struct Large {
+        // Bit `a % 64` of word `a / 64` is set if there is a child along `a`.
+        uint64_t bits[CHAR_CNT / 64];
+        // The number of children along the labels below each word of `bits`.
+        uint16_t below[CHAR_CNT / 64];
+        // The number of children there is room for.
+        int capacity;
+
+        WordTreeNode** children ();
+    };
+
     // The parent node. No parent is indicated with `nullptr`.
     WordTreeNode* m_parent;
 
-    // The hashmap of children nodes. Each entry represents an edge, the key
-    // being the edge label.
-    ChildMap m_children;
+    union {
+        Small m_small;
+        Medium* m_medium;
+        Large* m_large;
+    };
+
+    // The number of children.
+    uint16_t m_child_cnt;
+
+    // Which member of the union holds the children.
+    Kind m_kind;
 
     // Label of the edge along which this node is linked to its parent
     char m_link_char;
+
+    // Returns the labels and the children of an array representation.
+    uint8_t* labels ();
+    WordTreeNode** children ();
+
+    // Returns the number of children along labels less than `a` in the large
+    // representation.
+    int rank (uint8_t a) const;
+
+    // Allocates the large representation with room for `capacity` children
+    // and no bits set. The result is released with `delete_large()`.
+    static Large* new_large (int capacity);
+    static void delete_large (Large* large);
+
+    // Adds the child `node` along `a`, changing the representation if full.
+    void insert (uint8_t a, WordTreeNode* node);
+
+    // Removes the child along `a`, changing the representation if sparse.
+    void erase (uint8_t a);
+
+    // Switches to the large representation, from the medium one.
+    void make_large ();
+
+    // Switches to the other array representation, `kind`, or from the large
+    // one. The new one has to hold all the children.
+    void make_array (Kind kind);
+};
+
+// WordTreeNode::iterator
+// =============================================================================
+//
+// Visits the children as pairs of the edge label and the child node.
+template <typename T>
+class WordTreeNode<T>::iterator {
+public:
+    typedef pair<char, WordTreeNode*> value_type;
+
+    iterator (WordTreeNode* node, int pos);
+
+    value_type operator * () const;
+
+    value_type const* operator -> () const;
+
+    iterator& operator ++ ();
+
+    bool operator != (iterator const& it) const;
+
+private:
+    WordTreeNode* m_node;
+
+    // Index of the child among all of them.
+    int m_pos;
+
+    // The current child, unless past the end.
+    value_type m_value;
+
+    void load ();
 };
 
 template <typename T>
 template <typename... Args>
 inline WordTreeNode<T>::WordTreeNode (Args const&... args) :
     tag(args...),
-    m_parent(nullptr)
+    m_parent(nullptr),
+    m_small(),
+    m_child_cnt(0),
+    m_kind(SMALL)
 {
     assert(this->is_root());
 }
 
+template <typename T>
+inline WordTreeNode<T>::WordTreeNode (WordTreeNode&& node) :
+    tag(node.tag),
+    m_parent(node.m_parent),
+    m_child_cnt(node.m_child_cnt),
+    m_kind(node.m_kind),
+    m_link_char(node.m_link_char)
+{
+    if (m_kind == SMALL)
+        m_small = node.m_small;
+    else if (m_kind == MEDIUM)
+        m_medium = node.m_medium;
+    else
+        m_large = node.m_large;
+    node.m_child_cnt = 0;
+    node.m_kind = SMALL;
+}
+
+template <typename T>
+WordTreeNode<T>::~WordTreeNode () {
+    if (m_kind == MEDIUM)
+        delete m_medium;
+    else if (m_kind == LARGE)
+        delete_large(m_large);
+}
+
 template <typename T>
 inline WordTreeNode<T>* WordTreeNode<T>::parent () {
     return m_parent;
@@ -85,25 +237,67 @@ inline WordTreeNode<T>* WordTreeNode<T>::parent () {
 
 template <typename T>
 inline WordTreeNode<T>* WordTreeNode<T>::child (char a) {
-    auto it = m_children.find(a);
-    return it != m_children.end() ? it->second : nullptr;
+    uint8_t const label = a;
+    if (m_kind == SMALL) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // All the labels are compared at once, the matching one turning into
+        // a zero byte of `x`. The bit trick finds the lowest zero byte exactly,
+        // and there is at most one.
+        uint32_t labels;
+        memcpy(&labels, m_small.labels, SMALL_CNT);
+        uint32_t const x = labels ^ (0x01010101u * label);
+        uint32_t const used = (uint64_t(1) << (CHAR_BITS * m_child_cnt)) - 1;
+        uint32_t const zeros = (x - 0x01010101u) & ~x & 0x80808080u & used;
+        return zeros != 0
+            ? m_small.children[__builtin_ctz(zeros) / CHAR_BITS]
+            : nullptr;
+#else
+        for (int k = 0; k < m_child_cnt; ++k) {
+            if (m_small.labels[k] == label)
+                return m_small.children[k];
+        }
+        return nullptr;
+#endif
+    }
+    if (m_kind == MEDIUM) {
+#ifdef __SSE2__
+        // All the labels are compared at once. Those past the last child are
+        // left over from before and are masked out.
+        __m128i const labels = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(m_medium->labels)
+        );
+        int const mask = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(labels, _mm_set1_epi8(a))
+        ) & ((1 << m_child_cnt) - 1);
+        return mask != 0 ? m_medium->children[__builtin_ctz(mask)] : nullptr;
+#else
+        for (int k = 0; k < m_child_cnt; ++k) {
+            if (m_medium->labels[k] == label)
+                return m_medium->children[k];
+        }
+        return nullptr;
+#endif
+    }
+    if ((m_large->bits[label / 64] >> (label % 64) & 1) == 0)
+        return nullptr;
+    return m_large->children()[rank(label)];
 }
 
 template <typename T>
 inline typename WordTreeNode<T>::iterator WordTreeNode<T>::begin () {
-    return m_children.begin();
+    return iterator(this, 0);
 }
 
 template <typename T>
 inline typename WordTreeNode<T>::iterator WordTreeNode<T>::end () {
-    return m_children.end();
+    return iterator(this, m_child_cnt);
 }
 
 template <typename T>
 inline void WordTreeNode<T>::link_child (char a, WordTreeNode* node) {
-    auto insert = m_children.insert(make_pair(a, node));
-    assert(insert.second);
+    assert(child(a) == nullptr);
     node->unlink();
+    insert(a, node);
     node->m_parent = this;
     node->m_link_char = a;
 }
@@ -111,8 +305,8 @@ inline void WordTreeNode<T>::link_child (char a, WordTreeNode* node) {
 template <typename T>
 inline void WordTreeNode<T>::unlink () {
     if (!this->is_root()) {
-        assert(m_parent->m_children.count(m_link_char) == 1);
-        m_parent->m_children.erase(m_link_char);
+        assert(m_parent->child(m_link_char) == this);
+        m_parent->erase(m_link_char);
         m_parent = nullptr;
     }
 }
@@ -125,12 +319,12 @@ inline char WordTreeNode<T>::link_char () const {
 
 template <typename T>
 inline int WordTreeNode<T>::child_cnt () const {
-    return m_children.size();
+    return m_child_cnt;
 }
 
 template <typename T>
 inline bool WordTreeNode<T>::is_leaf () const {
-    return m_children.empty();
+    return m_child_cnt == 0;
 }
 
 template <typename T>
@@ -138,4 +332,211 @@ inline bool WordTreeNode<T>::is_root () const {
     return m_parent == nullptr;
 }
 
+template <typename T>
+int64_t WordTreeNode<T>::child_bytes () const {
+    if (m_kind == MEDIUM)
+        return sizeof(Medium);
+    if (m_kind == LARGE)
+        return sizeof(Large) + m_large->capacity * sizeof(WordTreeNode*);
+    return 0;
+}
+
+template <typename T>
+inline uint8_t* WordTreeNode<T>::labels () {
+    assert(m_kind != LARGE);
+    return m_kind == SMALL ? m_small.labels : m_medium->labels;
+}
+
+template <typename T>
+inline WordTreeNode<T>** WordTreeNode<T>::children () {
+    assert(m_kind != LARGE);
+    return m_kind == SMALL ? m_small.children : m_medium->children;
+}
+
+template <typename T>
+inline int WordTreeNode<T>::rank (uint8_t a) const {
+    uint64_t const lower = (uint64_t(1) << (a % 64)) - 1;
+    return m_large->below[a / 64]
+        + __builtin_popcountll(m_large->bits[a / 64] & lower);
+}
+
+template <typename T>
+typename WordTreeNode<T>::Large* WordTreeNode<T>::new_large (int capacity) {
+    void* const data =
+        operator new(sizeof(Large) + capacity * sizeof(WordTreeNode*));
+    Large* const large = new (data) Large();
+    large->capacity = capacity;
+    return large;
+}
+
+template <typename T>
+inline void WordTreeNode<T>::delete_large (Large* large) {
+    operator delete(large);
+}
+
+template <typename T>
+inline WordTreeNode<T>** WordTreeNode<T>::Large::children () {
+    return reinterpret_cast<WordTreeNode**>(this + 1);
+}
+
+template <typename T>
+void WordTreeNode<T>::insert (uint8_t a, WordTreeNode* node) {
+    if (m_kind == SMALL && m_child_cnt == SMALL_CNT)
+        make_array(MEDIUM);
+    else if (m_kind == MEDIUM && m_child_cnt == MEDIUM_CNT)
+        make_large();
+
+    if (m_kind == LARGE) {
+        if (m_child_cnt == m_large->capacity) {
+            Large* const large = new_large(min(2 * m_child_cnt, CHAR_CNT));
+            std::copy(m_large->bits, m_large->bits + CHAR_CNT / 64,
+                large->bits);
+            std::copy(m_large->below, m_large->below + CHAR_CNT / 64,
+                large->below);
+            std::copy(m_large->children(), m_large->children() + m_child_cnt,
+                large->children());
+            delete_large(m_large);
+            m_large = large;
+        }
+        WordTreeNode** const cs = m_large->children();
+        int const k = rank(a);
+        std::copy_backward(cs + k, cs + m_child_cnt, cs + m_child_cnt + 1);
+        cs[k] = node;
+        m_large->bits[a / 64] |= uint64_t(1) << (a % 64);
+        for (int w = a / 64 + 1; w < CHAR_CNT / 64; ++w)
+            ++m_large->below[w];
+    } else {
+        uint8_t* const ls = labels();
+        WordTreeNode** const cs = children();
+        int k = m_child_cnt;
+        for (; k > 0 && ls[k - 1] > a; --k) {
+            ls[k] = ls[k - 1];
+            cs[k] = cs[k - 1];
+        }
+        ls[k] = a;
+        cs[k] = node;
+    }
+    ++m_child_cnt;
+}
+
+template <typename T>
+void WordTreeNode<T>::erase (uint8_t a) {
+    if (m_kind == LARGE) {
+        WordTreeNode** const cs = m_large->children();
+        int const k = rank(a);
+        std::copy(cs + k + 1, cs + m_child_cnt, cs + k);
+        m_large->bits[a / 64] &= ~(uint64_t(1) << (a % 64));
+        for (int w = a / 64 + 1; w < CHAR_CNT / 64; ++w)
+            --m_large->below[w];
+    } else {
+        uint8_t* const ls = labels();
+        WordTreeNode** const cs = children();
+        int k = 0;
+        while (ls[k] != a)
+            ++k;
+        for (; k + 1 < m_child_cnt; ++k) {
+            ls[k] = ls[k + 1];
+            cs[k] = cs[k + 1];
+        }
+    }
+    --m_child_cnt;
+
+    if (m_kind == LARGE && m_child_cnt <= MEDIUM_CNT / 2)
+        make_array(MEDIUM);
+    else if (m_kind == MEDIUM && m_child_cnt <= SMALL_CNT / 2)
+        make_array(SMALL);
+}
+
+template <typename T>
+void WordTreeNode<T>::make_large () {
+    assert(m_kind == MEDIUM);
+    Large* const large = new_large(2 * MEDIUM_CNT);
+    for (int k = 0; k < m_child_cnt; ++k) {
+        uint8_t const a = m_medium->labels[k];
+        large->bits[a / 64] |= uint64_t(1) << (a % 64);
+        for (int w = a / 64 + 1; w < CHAR_CNT / 64; ++w)
+            ++large->below[w];
+        large->children()[k] = m_medium->children[k];
+    }
+    delete m_medium;
+    m_large = large;
+    m_kind = LARGE;
+}
+
+template <typename T>
+void WordTreeNode<T>::make_array (Kind kind) {
+    assert(kind != LARGE && kind != m_kind);
+    Small small;
+    Medium* const medium = kind == MEDIUM ? new Medium() : nullptr;
+    uint8_t* const ls = kind == SMALL ? small.labels : medium->labels;
+    WordTreeNode** const cs = kind == SMALL ? small.children : medium->children;
+    int k = 0;
+    for (auto kv : *this) {
+        ls[k] = kv.first;
+        cs[k] = kv.second;
+        ++k;
+    }
+    if (m_kind == LARGE)
+        delete_large(m_large);
+    else if (m_kind == MEDIUM)
+        delete m_medium;
+    if (kind == SMALL)
+        m_small = small;
+    else
+        m_medium = medium;
+    m_kind = kind;
+}
+
+template <typename T>
+inline WordTreeNode<T>::iterator::iterator (WordTreeNode* node, int pos) :
+    m_node(node),
+    m_pos(pos)
+{
+    load();
+}
+
+template <typename T>
+inline typename WordTreeNode<T>::iterator::value_type
+WordTreeNode<T>::iterator::operator * () const {
+    return m_value;
+}
+
+template <typename T>
+inline typename WordTreeNode<T>::iterator::value_type const*
+WordTreeNode<T>::iterator::operator -> () const {
+    return &m_value;
+}
+
+template <typename T>
+inline typename WordTreeNode<T>::iterator&
+WordTreeNode<T>::iterator::operator ++ () {
+    ++m_pos;
+    load();
+    return *this;
+}
+
+template <typename T>
+inline bool
+WordTreeNode<T>::iterator::operator != (iterator const& it) const {
+    return m_node != it.m_node || m_pos != it.m_pos;
+}
+
+template <typename T>
+void WordTreeNode<T>::iterator::load () {
+    if (m_pos == m_node->m_child_cnt)
+        return;
+    if (m_node->m_kind != LARGE) {
+        m_value.first = m_node->labels()[m_pos];
+        m_value.second = m_node->children()[m_pos];
+        return;
+    }
+    // The label is found by its rank, starting from the previous one.
+    Large* const large = m_node->m_large;
+    int a = m_pos == 0 ? 0 : uint8_t(m_value.first) + 1;
+    while ((large->bits[a / 64] >> (a % 64) & 1) == 0)
+        ++a;
+    m_value.first = a;
+    m_value.second = large->children()[m_pos];
+}
+
 #endif // WORD_TREE_NODE_H
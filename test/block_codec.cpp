@@ -0,0 +1,74 @@
+#include "prefix.h"
+
+#include "../src/block_codec.h"
+#include "../src/huffman.h"
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+class BlockCodecTest : public testing::Test {
+protected:
+    Buffer input;
+
+    BlockCodecTest ();
+};
+
+BlockCodecTest::BlockCodecTest () {
+    BufferCharWriter writer(input);
+    for (int i = 0; i < 300; ++i) {
+        writer.put("Sing, O goddess, the anger of Achilles son of Peleus, ");
+        writer.put(string(i % 11, 'a' + i % 3));
+    }
+}
+
+TEST_F (BlockCodecTest, EncodeDecode) {
+    Lz78<Smru> lz78(100);
+    Lzw<Wmru> lzw(100);
+    for (Lz const* lz : std::initializer_list<Lz const*>{&lz78, &lzw}) {
+        for (int worker_cnt : {0, 3}) {
+            ThreadPool pool(worker_cnt);
+            for (int64_t block_char_cnt : {1, 7, 1000, 1 << 20}) {
+                BlockCodec codec(*lz, block_char_cnt, pool);
+                ASSERT_EQ(input, codec.decode(codec.encode(input)));
+            }
+        }
+    }
+}
+
+TEST_F (BlockCodecTest, Empty) {
+    Lzw<Smru> lz(100);
+    ThreadPool pool(2);
+    BlockCodec codec(lz, 1000, pool);
+    Buffer output = codec.encode(Buffer());
+    ASSERT_EQ(128, output.size());
+    ASSERT_EQ(Buffer(), codec.decode(output));
+}
+
+TEST_F (BlockCodecTest, Layout) {
+    Lz78<Smru> lz(100);
+    ThreadPool pool(2);
+    int64_t const block_char_cnt = 5000;
+    BlockCodec codec(lz, block_char_cnt, pool);
+    Buffer output = codec.encode(input);
+    BufferView const view(output);
+    BufferBitReader reader(output);
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    ASSERT_EQ(char_cnt, int64_t(reader.get64()));
+    ASSERT_EQ(block_char_cnt, int64_t(reader.get64()));
+
+    // Every block is encoded on its own.
+    int64_t const block_cnt = ceil_div(char_cnt, block_char_cnt);
+    int64_t begin = 128 + 64 * block_cnt;
+    for (int64_t i = 0; i < block_cnt; ++i) {
+        BufferView const block = BufferView(input).slice_chars(
+            i * block_char_cnt,
+            min(block_char_cnt, char_cnt - i * block_char_cnt)
+        );
+        Buffer const expected = Huffman::encode(lz.encode(block));
+        int64_t const bit_cnt = reader.get64();
+        ASSERT_EQ(BufferView(expected), view.slice(begin, bit_cnt));
+        begin += bit_cnt;
+    }
+    ASSERT_EQ(output.size(), begin);
+}
@@ -1,8 +1,30 @@
 #include "prefix.h"
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
 
 #include "../src/buffer.h"
 
-TEST (BufferTest, BitIO) {
+template <typename Word>
+class BufferTest : public testing::Test {
+protected:
+    typedef BasicBuffer<Word> Buffer;
+    typedef BasicBufferBitReader<Word> BufferBitReader;
+    typedef BasicBufferBitWriter<Word> BufferBitWriter;
+    typedef BasicBufferCharReader<Word> BufferCharReader;
+    typedef BasicBufferCharWriter<Word> BufferCharWriter;
+};
+
+typedef testing::Types<uint32_t, uint64_t> words;
+TYPED_TEST_CASE(BufferTest, words);
+
+TYPED_TEST (BufferTest, BitIO) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+
     Buffer buffer;
 
     BufferBitWriter writer1(buffer);
@@ -14,12 +36,14 @@ TEST (BufferTest, BitIO) {
     ASSERT_EQ(20, buffer.size());
     writer1.put(0x1234ABCD, 32);
     ASSERT_EQ(52, buffer.size());
+    writer1.flush();
 
     BufferBitWriter writer2(buffer);
     writer2.put(0x0F0F0F0F, 32);
     ASSERT_EQ(84, buffer.size());
     writer2.put(0x00000001,  1);
     ASSERT_EQ(85, buffer.size());
+    writer2.flush();
 
     BufferBitReader reader(buffer);
     ASSERT_FALSE(reader.eob());
@@ -37,7 +61,11 @@ TEST (BufferTest, BitIO) {
     ASSERT_TRUE(reader.eob());
 }
 
-TEST (BufferTest, CharIO) {
+TYPED_TEST (BufferTest, CharIO) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferCharReader BufferCharReader;
+    typedef typename TestFixture::BufferCharWriter BufferCharWriter;
+
     Buffer buffer1;
     Buffer buffer2;
 
@@ -93,3 +121,376 @@ TEST (BufferTest, CharIO) {
     ASSERT_EQ('x', reader.get());
     ASSERT_TRUE(reader.eob());
 }
+
+TYPED_TEST (BufferTest, Reserve) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+
+    Buffer buffer;
+    BufferBitWriter writer(buffer);
+    writer.put(0x5, 3);
+    buffer.reserve(1000);
+    ASSERT_EQ(3, buffer.size());
+    for (int i = 0; i < 100; ++i)
+        writer.put(i, 10);
+    buffer.reserve(10);
+    ASSERT_EQ(1003, buffer.size());
+    writer.flush();
+
+    BufferBitReader reader(buffer);
+    ASSERT_EQ(0x5, reader.get(3));
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(i, reader.get(10));
+    ASSERT_TRUE(reader.eob());
+}
+
+TYPED_TEST (BufferTest, BatchedPut) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+    int const bits = WordTraits<TypeParam>::BITS;
+    // The `bit_cnt` least significant bits of some irregular pattern.
+    auto field = [bits] (int bit_cnt) {
+        return rshift(TypeParam(0x9E3779B97F4A7C15), bits - bit_cnt);
+    };
+
+    // Fields of every width, both batched and not, crossing word boundaries at
+    // every possible offset.
+    Buffer expected;
+    Buffer actual;
+    {
+        BufferBitWriter ewriter(expected);
+        BufferBitWriter awriter(actual);
+        for (int n1 = 0; n1 <= bits; ++n1) {
+            for (int n2 = 0; n2 <= bits; n2 += 7) {
+                ewriter.put(field(n1), n1);
+                ewriter.put(field(n2), n2);
+                awriter.put2(field(n1), n1, field(n2), n2);
+            }
+        }
+    }
+    ASSERT_EQ(expected, actual);
+
+    BufferBitReader reader(actual);
+    for (int n1 = 0; n1 <= bits; ++n1) {
+        for (int n2 = 0; n2 <= bits; n2 += 7) {
+            ASSERT_EQ(field(n1), reader.get(n1));
+            ASSERT_EQ(field(n2), reader.get(n2));
+        }
+    }
+    ASSERT_TRUE(reader.eob());
+}
+
+TYPED_TEST (BufferTest, EmptyField) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+    int const bits = WordTraits<TypeParam>::BITS;
+
+    // Empty fields on a fresh word, both at the start and right after a word
+    // has been filled up.
+    Buffer buffer;
+    {
+        BufferBitWriter writer(buffer);
+        writer.put(0, 0);
+        writer.put(1, 1);
+        writer.put(0, 0);
+        writer.put(0, bits - 1);
+        writer.put(0, 0);
+        writer.put(0x3, 2);
+        writer.put(0, 0);
+    }
+    ASSERT_EQ(bits + 2, buffer.size());
+
+    BufferBitReader reader(buffer);
+    ASSERT_EQ(TypeParam(0), reader.get(0));
+    ASSERT_EQ(TypeParam(1), reader.get(1));
+    ASSERT_EQ(TypeParam(0), reader.get(bits - 1));
+    ASSERT_EQ(TypeParam(0x3), reader.get(2));
+    ASSERT_TRUE(reader.eob());
+}
+
+TYPED_TEST (BufferTest, PeekConsume) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+
+    Buffer buffer;
+    BufferBitWriter writer(buffer);
+    writer.put(0x5, 3);
+    writer.put64(0x0123456789ABCDEF);
+    writer.put(0x1, 1);
+    writer.flush();
+
+    BufferBitReader reader(buffer);
+    ASSERT_EQ(68, reader.left());
+    ASSERT_EQ(0x0u, reader.peek(0));
+    ASSERT_EQ(0x5u, reader.peek(3));
+    ASSERT_EQ(0xA0246u, reader.peek(20));
+    ASSERT_EQ(0xA02468ACF13579BDu, reader.peek(64));
+    reader.consume(3);
+    ASSERT_EQ(65, reader.left());
+    ASSERT_EQ(0x0123456789ABCDEFu, reader.peek(64));
+    reader.consume(60);
+    ASSERT_EQ(0x1Fu, reader.peek(5));
+    ASSERT_EQ(0xFu, reader.get(4));
+    ASSERT_FALSE(reader.eob());
+    ASSERT_EQ(0x1u, reader.get(1));
+    ASSERT_TRUE(reader.eob());
+    ASSERT_EQ(0, reader.left());
+}
+
+TYPED_TEST (BufferTest, PeekAtEnd) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+
+    // Only the first two words are borrowed. The third one must never be
+    // loaded, not even by a peek at the end of the buffer.
+    TypeParam const data[3] = { 0, 0, TypeParam(~TypeParam(0)) };
+    Buffer buffer(data, 2 * sizeof(TypeParam));
+    BufferBitReader reader(buffer);
+    reader.consume(reader.left());
+    ASSERT_TRUE(reader.eob());
+    ASSERT_EQ(0x0u, reader.peek(64));
+}
+
+TYPED_TEST (BufferTest, BulkCharIO) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferCharWriter BufferCharWriter;
+
+    // Longer than a single read chunk and not a whole number of words.
+    string data;
+    for (int i = 0; i < 200003; ++i)
+        data += 'a' + i * 7 % 26;
+    string const path = testing::TempDir() + "lzc_buffer_test";
+    std::ofstream(path.c_str()) << data;
+
+    Buffer expected;
+    BufferCharWriter ewriter(expected);
+    ewriter.put('x');
+    for (char c : data)
+        ewriter.put(c);
+    ewriter.put("yz");
+
+    Buffer from_chars;
+    BufferCharWriter cwriter(from_chars);
+    cwriter.put('x');
+    cwriter.put(data.data(), data.size());
+    cwriter.put("yz", 2);
+    ASSERT_EQ(expected, from_chars);
+
+    Buffer from_stream;
+    BufferCharWriter swriter(from_stream);
+    swriter.put('x');
+    std::istringstream istr(data);
+    ASSERT_EQ(int64_t(data.size()), swriter.put_stream(istr));
+    swriter.put("yz");
+    ASSERT_EQ(expected, from_stream);
+
+    Buffer from_fd;
+    BufferCharWriter fwriter(from_fd);
+    fwriter.put('x');
+    int const fd = open(path.c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(int64_t(data.size()), fwriter.put_fd(fd));
+    close(fd);
+    std::remove(path.c_str());
+    fwriter.put("yz");
+    ASSERT_EQ(expected, from_fd);
+
+    ASSERT_EQ(-1, fwriter.put_fd(-1));
+    ASSERT_EQ(expected, from_fd);
+}
+
+TYPED_TEST (BufferTest, Clear) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+
+    Buffer buffer;
+    BufferBitWriter(buffer).put(0x7, 3);
+    buffer.clear();
+    ASSERT_EQ(0, buffer.size());
+    ASSERT_EQ(Buffer(), buffer);
+    BufferBitWriter(buffer).put(0x1, 2);
+    BufferBitReader reader(buffer);
+    ASSERT_EQ(0x1u, reader.get(2));
+    ASSERT_TRUE(reader.eob());
+}
+
+// Counts the words allocated and not yet deallocated.
+template <typename Word>
+class CountingAllocator : public BasicBufferAllocator<Word> {
+public:
+    int64_t live_word_cnt = 0;
+
+    virtual Word* allocate (int64_t& word_cnt) {
+        live_word_cnt += word_cnt;
+        return new Word[word_cnt];
+    }
+
+    virtual void deallocate (Word* data, int64_t word_cnt) {
+        live_word_cnt -= word_cnt;
+        delete[] data;
+    }
+};
+
+TYPED_TEST (BufferTest, Allocator) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferCharWriter BufferCharWriter;
+
+    CountingAllocator<TypeParam> allocator;
+    {
+        Buffer buffer(allocator);
+        BufferCharWriter writer(buffer);
+        writer.put(string(1000, 'x'));
+        buffer.reserve(100000);
+        int64_t const word_cnt = 100000 / WordTraits<TypeParam>::BITS;
+        ASSERT_LE(word_cnt, allocator.live_word_cnt);
+        Buffer moved(std::move(buffer));
+    }
+    ASSERT_EQ(0, allocator.live_word_cnt);
+}
+
+TYPED_TEST (BufferTest, RecyclingAllocator) {
+    BasicRecyclingBufferAllocator<TypeParam>& allocator =
+        BasicRecyclingBufferAllocator<TypeParam>::instance();
+    allocator.trim();
+
+    int64_t word_cnt = 5;
+    TypeParam* data = allocator.allocate(word_cnt);
+    ASSERT_EQ(8, word_cnt);
+    allocator.deallocate(data, word_cnt);
+    word_cnt = 7;
+    ASSERT_EQ(data, allocator.allocate(word_cnt));
+    ASSERT_EQ(8, word_cnt);
+    allocator.deallocate(data, word_cnt);
+    word_cnt = 9;
+    TypeParam* const other_data = allocator.allocate(word_cnt);
+    ASSERT_NE(data, other_data);
+    ASSERT_EQ(16, word_cnt);
+    allocator.deallocate(other_data, word_cnt);
+
+    allocator.trim();
+}
+
+TYPED_TEST (BufferTest, View) {
+    typedef typename TestFixture::Buffer Buffer;
+    typedef typename TestFixture::BufferBitReader BufferBitReader;
+    typedef typename TestFixture::BufferBitWriter BufferBitWriter;
+    typedef typename TestFixture::BufferCharReader BufferCharReader;
+    typedef typename TestFixture::BufferCharWriter BufferCharWriter;
+    typedef BasicBufferView<TypeParam> BufferView;
+
+    BufferView view;
+    {
+        Buffer buffer;
+        BufferCharWriter(buffer).put("abcdefghijklmnopqrstuvwxyz");
+        view = std::move(buffer);
+    }
+    ASSERT_EQ(26 * CHAR_BITS, view.size());
+
+    // The slices outlive the view they come from.
+    BufferView chars = view.slice_chars(3, 20).slice_chars(2, 9);
+    view = BufferView();
+    ASSERT_TRUE(chars.is_char_aligned());
+    BufferCharReader creader(chars);
+    string s;
+    while (!creader.eob())
+        s += creader.get();
+    ASSERT_EQ("fghijklmn", s);
+    ASSERT_EQ("ghi", BufferCharSlice(chars, 1, 3));
+
+    Buffer buffer;
+    BufferBitWriter writer(buffer);
+    writer.put(0x5, 3);
+    writer.put64(0x0123456789ABCDEF);
+    writer.put(0x1, 1);
+    writer.flush();
+
+    BufferView bits = BufferView(buffer).slice(3, 64).slice(4, 40);
+    ASSERT_FALSE(bits.is_char_aligned());
+    BufferBitReader breader(bits);
+    ASSERT_EQ(40, breader.left());
+    ASSERT_EQ(0x123456789u, breader.peek(36));
+    ASSERT_EQ(0x0u, breader.get(3));
+    breader.consume(33);
+    ASSERT_EQ(0xAu, breader.get(4));
+    ASSERT_TRUE(breader.eob());
+
+    Buffer expected;
+    BufferBitWriter ewriter(expected);
+    ewriter.put(0x12, 8);
+    ewriter.put(0x3456789A, 32);
+    ewriter.flush();
+    ASSERT_TRUE(bits == BufferView(expected));
+    ASSERT_FALSE(bits == BufferView(buffer).slice(0, 40));
+}
+
+TEST (BufferTest, AppendAndCopy) {
+    Buffer buffer;
+    BufferCharWriter writer(buffer);
+    writer.put("abc");
+    // The address is only valid until the buffer is altered.
+    memcpy(writer.append(4), "defg", 4);
+    writer.put_copy(1, 2);
+    ASSERT_EQ(9 * CHAR_BITS, buffer.size());
+    ASSERT_EQ("abcdefgbc", BufferCharSlice(buffer, 0, 9));
+
+    char array[6];
+    CharArrayWriter array_writer(array, 6);
+    array_writer.put('x');
+    array_writer.put('y');
+    array_writer.put_copy(0, 2);
+    array_writer.put_copy(1, 2);
+    ASSERT_EQ(6, array_writer.pos());
+    ASSERT_EQ("xyxyyx", string(array, 6));
+}
+
+TEST (BufferTest, OverlappingCopy) {
+    Buffer buffer;
+    BufferCharWriter writer(buffer);
+    writer.put("ab");
+    // The copy runs into its destination and repeats the last chars.
+    writer.put_copy(0, 7);
+    writer.put_copy(7, 3);
+    ASSERT_EQ("abababababab", BufferCharSlice(buffer, 0, 12));
+}
+
+TEST (BufferTest, ChunkedCopy) {
+    int const char_cnt = 200;
+    int const slack_cnt = CharArrayWriter::CHUNK;
+    // Pairs of the distance back and the length of the copies, overlapping
+    // ones included.
+    std::vector<std::pair<int, int>> const copies = {
+        {1, 1}, {3, 20}, {45, 5}, {50, 40}, {3, 20}, {1, 17}, {17, 50}, {1, 0},
+        {150, 21}
+    };
+    // The alphabet followed by the copies done char by char.
+    string expected;
+    for (char a = 'a'; a <= 'z'; ++a)
+        expected.push_back(a);
+    for (auto const& copy : copies) {
+        int64_t const begin = expected.size() - copy.first;
+        for (int i = 0; i < copy.second; ++i)
+            expected.push_back(expected[begin + i]);
+    }
+    ASSERT_EQ(size_t(char_cnt), expected.size());
+
+    // Without the slack, the copies near the end go char by char.
+    for (int slack : {0, slack_cnt}) {
+        char array[char_cnt + slack_cnt];
+        std::fill(array, array + char_cnt + slack_cnt, '#');
+        CharArrayWriter writer(array, char_cnt, slack);
+        for (char a = 'a'; a <= 'z'; ++a)
+            writer.put(a);
+        for (auto const& copy : copies)
+            writer.put_copy(writer.pos() - copy.first, copy.second);
+        ASSERT_EQ(char_cnt, writer.pos());
+        ASSERT_EQ(expected, string(array, char_cnt));
+        // Nothing is written past the slack.
+        ASSERT_EQ(string(slack_cnt - slack, '#'),
+            string(array + char_cnt + slack, slack_cnt - slack));
+    }
+}
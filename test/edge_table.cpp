@@ -0,0 +1,67 @@
+#include "prefix.h"
+#include <map>
+
+#include "../src/edge_table.h"
+
+template <typename Key>
+class EdgeTableTest : public testing::Test {
+protected:
+    typedef EdgeTable<Key, int> Edges;
+};
+
+typedef testing::Types<uint32_t, uint64_t> keys;
+TYPED_TEST_CASE(EdgeTableTest, keys);
+
+TYPED_TEST (EdgeTableTest, Operations) {
+    typedef typename TestFixture::Edges Edges;
+
+    Edges edges(2);
+    TypeParam const k1 = Edges::key(0, 'a');
+    TypeParam const k2 = Edges::key(0, 'b');
+    TypeParam const k3 = Edges::key(1, 'a');
+    ASSERT_EQ(Edges::NO_KEY, edges[edges.find(k1)].key);
+    edges.insert(edges.find(k1), k1, 1);
+    edges.insert(edges.find(k2), k2, 2);
+    // The table is full enough to grow now.
+    edges.insert(edges.find(k3), k3, 3);
+    ASSERT_EQ(1, edges[edges.find(k1)].value);
+    ASSERT_EQ(2, edges[edges.find(k2)].value);
+    ASSERT_EQ(3, edges[edges.find(k3)].value);
+    edges.remove(edges.find(k2));
+    ASSERT_EQ(Edges::NO_KEY, edges[edges.find(k2)].key);
+    ASSERT_EQ(1, edges[edges.find(k1)].value);
+    ASSERT_EQ(3, edges[edges.find(k3)].value);
+    edges.clear();
+    ASSERT_EQ(Edges::NO_KEY, edges[edges.find(k1)].key);
+    ASSERT_EQ(Edges::NO_KEY, edges[edges.find(k3)].key);
+}
+
+TYPED_TEST (EdgeTableTest, SameAsMap) {
+    typedef typename TestFixture::Edges Edges;
+
+    // Few parents and labels, so that the keys keep coming back and the
+    // probe sequences cross each other and wrap around the table.
+    Edges edges(1);
+    std::map<TypeParam, int> map;
+    uint32_t state = 5;
+    for (int k = 0; k < 20000; ++k) {
+        state = state * 1103515245 + 12345;
+        TypeParam const key = Edges::key((state >> 8) % 40, (state >> 16) % 8);
+        int const s = edges.find(key);
+        auto it = map.find(key);
+        if (it == map.end()) {
+            ASSERT_EQ(Edges::NO_KEY, edges[s].key);
+            edges.insert(s, key, k);
+            map[key] = k;
+        } else {
+            ASSERT_EQ(key, edges[s].key);
+            ASSERT_EQ(it->second, edges[s].value);
+            if ((state >> 28) % 2 == 0) {
+                edges.remove(s);
+                map.erase(it);
+            }
+        }
+    }
+    for (auto const& kv : map)
+        ASSERT_EQ(kv.second, edges[edges.find(kv.first)].value);
+}
@@ -0,0 +1,136 @@
+#include "prefix.h"
+#include <vector>
+
+#include "../src/buffer.h"
+#include "../src/hash_dict.h"
+#include "../src/mra_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+// Checks that `EncodeDict::next_match()` finds the same matches as the char
+// by char `EncodeDict::try_char()`.
+template <typename Dict>
+class EncodeDictTest : public testing::Test {
+protected:
+    Buffer text;
+    Buffer binary;
+
+    EncodeDictTest ();
+
+    // Factorizes `input` with `try_char()`, the LZW way if `lzw` is set.
+    std::vector<Match> by_char (Buffer const& input, int limit, bool lzw);
+
+    // Factorizes `input` with `next_match()`.
+    std::vector<Match> by_match (Buffer const& input, int limit, bool lzw);
+};
+
+template <typename Dict>
+EncodeDictTest<Dict>::EncodeDictTest () {
+    BufferCharWriter text_writer(text);
+    for (int i = 0; i < 200; ++i) {
+        text_writer.put("abracadabra ");
+        text_writer.put(string(i % 17, 'a' + i % 5));
+        text_writer.put("cabracabra");
+    }
+
+    BufferCharWriter binary_writer(binary);
+    uint32_t state = 7;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 1103515245 + 12345;
+        // Skewed towards a few values, so that there are long matches.
+        binary_writer.put(char((state >> 16) % 4 == 0 ? state >> 8 : 0));
+    }
+}
+
+template <typename Dict>
+std::vector<Match> EncodeDictTest<Dict>::by_char (
+    Buffer const& input,
+    int limit,
+    bool lzw
+) {
+    Dict dict(input, limit, lzw);
+    // Unlike LZ78, LZW puts back the extending char.
+    int64_t const kept = lzw ? 0 : 1;
+    std::vector<Match> matches;
+    int64_t ahead = 0;
+    while (!dict.eob()) {
+        while (!dict.eob()) {
+            Match match = dict.try_char();
+            ++ahead;
+            if (match.is_maximal()) {
+                matches.push_back(match);
+                dict.put_back(ahead - match.length - kept);
+                ahead = 0;
+            }
+        }
+        if (ahead != 0) {
+            Match match = dict.fail_char();
+            matches.push_back(match);
+            if (match.length != ahead) {
+                dict.put_back(ahead - match.length - kept);
+                ahead = 0;
+            }
+        }
+    }
+    return matches;
+}
+
+template <typename Dict>
+std::vector<Match> EncodeDictTest<Dict>::by_match (
+    Buffer const& input,
+    int limit,
+    bool lzw
+) {
+    Dict dict(input, limit, lzw);
+    std::vector<Match> matches;
+    while (!dict.eob()) {
+        matches.push_back(dict.next_match(true));
+        if (!lzw && !dict.eob())
+            dict.skip(1);
+    }
+    return matches;
+}
+
+typedef testing::Types<
+    Smru::EncodeDict,
+    Smru2::EncodeDict,
+    FlatSmru::EncodeDict,
+    Wmru::EncodeDict,
+    Mra::EncodeDict,
+    HashSmru::EncodeDict,
+    HashWmru::EncodeDict,
+    HashMra::EncodeDict
+> dicts;
+TYPED_TEST_CASE(EncodeDictTest, dicts);
+
+TYPED_TEST (EncodeDictTest, NextMatch) {
+    for (int limit : {300, 1000}) {
+        for (bool lzw : {false, true}) {
+            ASSERT_EQ(
+                this->by_char(this->text, limit, lzw),
+                this->by_match(this->text, limit, lzw)
+            );
+            ASSERT_EQ(
+                this->by_char(this->binary, limit, lzw),
+                this->by_match(this->binary, limit, lzw)
+            );
+        }
+    }
+}
+
+TYPED_TEST (EncodeDictTest, NextMatchNotLast) {
+    TypeParam dict(this->text, 300, false);
+    int64_t pos = 0;
+    while (!dict.eob()) {
+        pos = dict.next_pos();
+        if (!dict.next_match(false).is_maximal())
+            break;
+        if (!dict.eob())
+            dict.skip(1);
+    }
+    // The text ends with a repetition, so it's bound to end with a partial
+    // match, which is left in place.
+    ASSERT_FALSE(dict.eob());
+    ASSERT_EQ(pos, dict.next_pos());
+    ASSERT_TRUE(dict.next_match(true).is_maximal());
+}
@@ -1,6 +1,7 @@
 #include "prefix.h"
 
 #include "../src/buffer.h"
+#include "../src/hash_dict.h"
 #include "../src/lz78.h"
 #include "../src/lzw.h"
 #include "../src/mra_dict.h"
@@ -70,7 +71,15 @@ typedef testing::Types<
     Lz78<Wmru>,
     Lzw<Wmru>,
     Lz78<Smru2>,
-    Lzw<Smru2>
+    Lzw<Smru2>,
+    Lz78<FlatSmru>,
+    Lzw<FlatSmru>,
+    Lz78<HashSmru>,
+    Lzw<HashSmru>,
+    Lz78<HashMra>,
+    Lzw<HashMra>,
+    Lz78<HashWmru>,
+    Lzw<HashWmru>
 > algos;
 TYPED_TEST_CASE(EncodeDecodeTest, algos);
 
@@ -88,3 +97,132 @@ TYPED_TEST (EncodeDecodeTest, Alphabet) {
     TypeParam lz(40);
     ASSERT_EQ(this->alphabet, lz.decode(lz.encode(this->alphabet)));
 }
+
+TYPED_TEST (EncodeDecodeTest, MaxEncodedBits) {
+    TypeParam lz(10);
+    int64_t const char_cnt = this->lorem_ipsum.size() / CHAR_BITS;
+    Buffer output = lz.encode(this->lorem_ipsum);
+    ASSERT_GE(lz.max_encoded_bits(char_cnt), output.size());
+    ASSERT_GE(lz.max_encoded_bits(1), lz.encode(this->single_char).size());
+}
+
+TYPED_TEST (EncodeDecodeTest, ReuseBuffers) {
+    TypeParam lz(10);
+    Buffer output(RecyclingBufferAllocator::instance());
+    Buffer input(RecyclingBufferAllocator::instance());
+    lz.encode(this->lorem_ipsum, output);
+    lz.decode(output, input);
+    ASSERT_EQ(this->lorem_ipsum, input);
+    lz.encode(this->single_char, output);
+    ASSERT_EQ(lz.encode(this->single_char), output);
+    lz.decode(output, input);
+    ASSERT_EQ(this->single_char, input);
+}
+
+TYPED_TEST (EncodeDecodeTest, View) {
+    TypeParam lz(10);
+    BufferView const view = BufferView(this->lorem_ipsum).slice_chars(5, 301);
+    Buffer copy;
+    BufferCharWriter(copy).put(BufferCharSlice(view, 0, 301));
+    Buffer output = lz.encode(view);
+    ASSERT_EQ(lz.encode(copy), output);
+    ASSERT_EQ(copy, lz.decode(output));
+}
+
+TYPED_TEST (EncodeDecodeTest, VariableWidth) {
+    for (int limit : {10, 40, 1000}) {
+        TypeParam fixed(limit);
+        TypeParam lz(limit, true);
+        for (Buffer const* input : {
+            &this->single_char,
+            &this->lorem_ipsum,
+            &this->alphabet
+        }) {
+            Buffer const output = lz.encode(*input);
+            ASSERT_EQ(*input, lz.decode(output));
+            ASSERT_LE(output.size(), fixed.encode(*input).size());
+            ASSERT_GE(lz.max_encoded_bits(input->size() / CHAR_BITS),
+                      output.size());
+        }
+    }
+    // Larger dictionaries gain the most.
+    TypeParam fixed(1000);
+    TypeParam lz(1000, true);
+    ASSERT_LT(
+        lz.encode(this->lorem_ipsum).size(),
+        fixed.encode(this->lorem_ipsum).size()
+    );
+}
+
+// Collects the decoded chunks and records the size of the largest one.
+class ChunkSink final : public DecodeSink {
+public:
+    Buffer buffer;
+    int64_t chunk_cnt = 0;
+    int64_t max_chunk = 0;
+
+    virtual void put (char const* data, int64_t char_cnt) {
+        BufferCharWriter(buffer).put(data, char_cnt);
+        ++chunk_cnt;
+        max_chunk = max(max_chunk, char_cnt);
+    }
+};
+
+TYPED_TEST (EncodeDecodeTest, Sink) {
+    for (int limit : {10, 40, 1000}) {
+        TypeParam lz(limit);
+        for (Buffer const* input : {
+            &this->single_char,
+            &this->lorem_ipsum,
+            &this->alphabet
+        }) {
+            ChunkSink sink;
+            lz.decode(lz.encode(*input), sink);
+            ASSERT_EQ(*input, sink.buffer);
+            ASSERT_LE(sink.max_chunk, SinkWriter::CHUNK_CNT);
+        }
+    }
+}
+
+TYPED_TEST (EncodeDecodeTest, SinkChunks) {
+    TypeParam lz(100);
+    Buffer input;
+    BufferCharWriter writer(input);
+    for (int i = 0; i < 1000; ++i)
+        writer.put(BufferCharSlice(this->lorem_ipsum, i % 7, 200 + i % 13));
+    ChunkSink sink;
+    lz.decode(lz.encode(input), sink);
+    ASSERT_EQ(input, sink.buffer);
+    ASSERT_LT(1, sink.chunk_cnt);
+}
+
+TYPED_TEST (EncodeDecodeTest, Array) {
+    TypeParam lz(10);
+    int64_t const char_cnt = this->lorem_ipsum.size() / CHAR_BITS;
+    // Decode into the middle of a presized buffer.
+    Buffer input;
+    input.reserve((char_cnt + 4) * CHAR_BITS);
+    BufferCharWriter writer(input);
+    writer.put("<<");
+    char* const dest = writer.append(char_cnt);
+    writer.put(">>");
+    lz.decode(lz.encode(this->lorem_ipsum), dest, char_cnt);
+    ASSERT_EQ(
+        BufferCharSlice(this->lorem_ipsum, 0, char_cnt),
+        BufferCharSlice(input, 2, char_cnt)
+    );
+    ASSERT_EQ(">>", BufferCharSlice(input, char_cnt + 2, 2));
+}
+
+TYPED_TEST (EncodeDecodeTest, VariableWidthDecoders) {
+    TypeParam lz(40, true);
+    Buffer const output = lz.encode(this->lorem_ipsum);
+    int64_t const char_cnt = this->lorem_ipsum.size() / CHAR_BITS;
+    ChunkSink sink;
+    lz.decode(output, sink);
+    ASSERT_EQ(this->lorem_ipsum, sink.buffer);
+    Buffer input;
+    char* const dest = BufferCharWriter(input).append(char_cnt);
+    lz.decode(output, dest, char_cnt);
+    ASSERT_EQ(this->lorem_ipsum, input);
+}
@@ -0,0 +1,58 @@
+#include "prefix.h"
+
+#include "../src/buffer.h"
+#include "../src/hash_dict.h"
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+
+// Checks that the hash table dictionaries produce the very same encodings as
+// the tree ones they stand in for.
+class HashDictTest : public testing::Test {
+protected:
+    Buffer input;
+
+    HashDictTest ();
+
+    template <typename Lz1, typename Lz2>
+    void assert_same (int limit) const;
+};
+
+HashDictTest::HashDictTest () {
+    BufferCharWriter writer(input);
+    uint32_t state = 11;
+    for (int i = 0; i < 3000; ++i) {
+        state = state * 1103515245 + 12345;
+        // Words repeated often enough to make long codewords, and some noise
+        // to make the pools discard them.
+        writer.put(string((state >> 16) % 7, 'a' + (state >> 8) % 3));
+        writer.put((state >> 20) % 4 == 0 ? char(state >> 24) : ' ');
+        writer.put("lorem ipsum");
+    }
+}
+
+template <typename Lz1, typename Lz2>
+void HashDictTest::assert_same (int limit) const {
+    Lz1 lz1(limit);
+    Lz2 lz2(limit);
+    Buffer output = lz2.encode(input);
+    ASSERT_EQ(lz1.encode(input), output);
+    ASSERT_EQ(input, lz2.decode(output));
+}
+
+TEST_F (HashDictTest, Lz78) {
+    for (int limit : {1, 10, 300, 4096}) {
+        assert_same<Lz78<Smru>, Lz78<HashSmru>>(limit);
+        assert_same<Lz78<Smru>, Lz78<FlatSmru>>(limit);
+        assert_same<Lz78<Wmru>, Lz78<HashWmru>>(limit);
+        assert_same<Lz78<Mra>, Lz78<HashMra>>(limit);
+    }
+}
+
+TEST_F (HashDictTest, Lzw) {
+    for (int limit : {1, 10, 300, 4096}) {
+        assert_same<Lzw<Smru>, Lzw<HashSmru>>(limit);
+        assert_same<Lzw<Smru>, Lzw<FlatSmru>>(limit);
+        assert_same<Lzw<Wmru>, Lzw<HashWmru>>(limit);
+        assert_same<Lzw<Mra>, Lzw<HashMra>>(limit);
+    }
+}
@@ -35,5 +35,66 @@ TEST (HuffmanTest, Uneven) {
     writer.put(0x12345678, 32);
     writer.put(0x12345678, 32);
     writer.put(0x0009ABCD, 20);
+    writer.flush();
     ASSERT_EQ(input, Huffman::decode(Huffman::encode(input)));
-}
\ No newline at end of file
+}
+
+TEST (HuffmanTest, Empty) {
+    Buffer const output = Huffman::encode(Buffer());
+    // Just the weight width, the last word and its length.
+    ASSERT_EQ(6 + 64 + 6, output.size());
+    ASSERT_EQ(Buffer(), Huffman::decode(output));
+}
+
+TEST (HuffmanTest, WeightWidth) {
+    // The weights take only as many bits as the largest one needs, which here
+    // is ten, and the payload can't exceed the input.
+    Buffer input;
+    BufferCharWriter writer(input);
+    writer.put(string(996, 'a') + "bcdd");
+    writer.put("xy");
+    Buffer const output = Huffman::encode(input);
+    ASSERT_GE(6 + CHAR_CNT * 10 + 6 + 64 + 1000 * CHAR_BITS, output.size());
+    ASSERT_EQ(input, Huffman::decode(output));
+}
+
+// Returns a buffer backed by `To` words holding the same bits as `buffer`.
+template <typename To, typename From>
+BasicBuffer<To> rewrap (BasicBuffer<From> const& buffer) {
+    BasicBuffer<To> result;
+    BasicBufferBitWriter<To> writer(result);
+    BasicBufferBitReader<From> reader(buffer);
+    while (!reader.eob()) {
+        int const bit_cnt = min<int64_t>(INT_BITS, reader.left());
+        writer.put(reader.get(bit_cnt), bit_cnt);
+    }
+    writer.flush();
+    return result;
+}
+
+TEST (HuffmanTest, CrossWidth) {
+    // Both text and bits that don't end on a char boundary.
+    BasicBuffer<uint64_t> input64;
+    {
+        BasicBufferBitWriter<uint64_t> writer(input64);
+        uint32_t state = 3;
+        for (int i = 0; i < 1000; ++i) {
+            state = state * 1103515245 + 12345;
+            writer.put(state >> 28, 4);
+            writer.put('a' + (state >> 8) % 5, CHAR_BITS);
+        }
+        writer.put(0x5, 3);
+    }
+    BasicBuffer<uint32_t> const input32 = rewrap<uint32_t>(input64);
+
+    BasicBuffer<uint64_t> const output64 =
+        BasicHuffman<uint64_t>::encode(input64);
+    BasicBuffer<uint32_t> const output32 =
+        BasicHuffman<uint32_t>::encode(input32);
+    ASSERT_EQ(input32, BasicHuffman<uint32_t>::decode(
+        rewrap<uint32_t>(output64)
+    ));
+    ASSERT_EQ(input64, BasicHuffman<uint64_t>::decode(
+        rewrap<uint64_t>(output32)
+    ));
+}
@@ -0,0 +1,74 @@
+#include "prefix.h"
+#include <list>
+#include <vector>
+
+#include "../src/index_queue.h"
+
+// Pops all elements of `queue` from the front.
+std::vector<int> drain (IndexQueue& queue) {
+    std::vector<int> elements;
+    while (!queue.empty()) {
+        elements.push_back(queue.front());
+        queue.erase(queue.front());
+    }
+    return elements;
+}
+
+TEST (IndexQueueTest, Operations) {
+    IndexQueue queue(6);
+    ASSERT_TRUE(queue.empty());
+    queue.push_back(3);
+    queue.push_back(1);
+    queue.push_front(5);
+    queue.insert(1, 2);
+    // 5 3 2 1
+    ASSERT_TRUE(queue.contains(2));
+    ASSERT_FALSE(queue.contains(4));
+    queue.move_to_back(3);
+    queue.erase(2);
+    queue.insert(5, 6);
+    // 6 5 1 3
+    ASSERT_FALSE(queue.contains(2));
+    ASSERT_EQ(std::vector<int>({6, 5, 1, 3}), drain(queue));
+    ASSERT_FALSE(queue.contains(6));
+}
+
+TEST (IndexQueueTest, Clear) {
+    IndexQueue queue(4);
+    queue.push_back(4);
+    queue.push_back(2);
+    queue.clear();
+    ASSERT_TRUE(queue.empty());
+    ASSERT_FALSE(queue.contains(4));
+    ASSERT_FALSE(queue.contains(2));
+    queue.push_back(2);
+    ASSERT_EQ(std::vector<int>({2}), drain(queue));
+}
+
+TEST (IndexQueueTest, SameAsList) {
+    int const capacity = 100;
+    IndexQueue queue(capacity);
+    std::list<int> list;
+    uint32_t state = 7;
+    for (int k = 0; k < 10000; ++k) {
+        state = state * 1103515245 + 12345;
+        int const i = 1 + (state >> 8) % capacity;
+        auto it = std::find(list.begin(), list.end(), i);
+        ASSERT_EQ(it != list.end(), queue.contains(i));
+        if (it != list.end() && (state >> 24) % 2 == 0) {
+            list.erase(it);
+            list.push_back(i);
+            queue.move_to_back(i);
+        } else if (it != list.end()) {
+            list.erase(it);
+            queue.erase(i);
+        } else if (list.empty() || (state >> 24) % 2 == 0) {
+            list.push_back(i);
+            queue.push_back(i);
+        } else {
+            queue.insert(list.front(), i);
+            list.push_front(i);
+        }
+    }
+    ASSERT_EQ(std::vector<int>(list.begin(), list.end()), drain(queue));
+}
@@ -0,0 +1,38 @@
+#include "prefix.h"
+
+#include "../src/buffer.h"
+#include "../src/lzw.h"
+#include "../src/mra_dict.h"
+
+// These tests need several gigabytes of memory and take minutes to run, so
+// they are disabled by default. Run them with
+// `--gtest_also_run_disabled_tests`.
+
+int64_t const FOUR_GIB = int64_t(1) << 32;
+
+TEST (LargeInputTest, DISABLED_BitCountPastInt) {
+    // 2^32 bits is where a 32 bit bit counter would overflow.
+    int64_t const char_cnt = FOUR_GIB / CHAR_BITS + 3;
+    Buffer buffer;
+    BufferCharWriter writer(buffer);
+    for (int64_t i = 0; i < char_cnt; ++i)
+        writer.put(char(i % 251));
+    ASSERT_EQ(char_cnt * CHAR_BITS, buffer.size());
+
+    BufferCharReader reader(buffer);
+    for (int64_t i = 0; i < char_cnt; ++i)
+        ASSERT_EQ(char(i % 251), reader.get());
+    ASSERT_TRUE(reader.eob());
+}
+
+TEST (LargeInputTest, DISABLED_EncodeDecodePastFourGiB) {
+    int64_t const char_cnt = FOUR_GIB + FOUR_GIB / 8;
+    Buffer input;
+    BufferCharWriter writer(input);
+    for (int64_t i = 0; i < char_cnt; ++i)
+        writer.put(char('a' + (i / 4096) % 16));
+    ASSERT_EQ(char_cnt * CHAR_BITS, input.size());
+
+    Lzw<Mra> lzw(4096);
+    ASSERT_EQ(input, lzw.decode(lzw.encode(input)));
+}
@@ -21,6 +21,7 @@ SmruLz78Test::SmruLz78Test () :
     iwriter.put("aababbacabca");
 
     BufferBitWriter owriter(output);
+    owriter.put64(12); // Input length.
     owriter.put( 0 , codeword_no_length);
     owriter.put('a', CHAR_BITS       ); // a|
     owriter.put( 1 , codeword_no_length);
@@ -41,3 +42,27 @@ TEST_F (SmruLz78Test, Encoding) {
 TEST_F (SmruLz78Test, Decoding) {
     ASSERT_EQ(input, lz78.decode(output));
 }
+
+TEST_F (SmruLz78Test, VariableWidth) {
+    // Every codeword number takes just as many bits as the greatest number in
+    // the dictionary at that time needs.
+    Lz78<Smru> lz78(3, true);
+    Buffer output;
+    BufferBitWriter owriter(output);
+    owriter.put64(12); // Input length.
+    owriter.put( 0 , 0        );
+    owriter.put('a', CHAR_BITS); // a|
+    owriter.put( 1 , 1        );
+    owriter.put('b', CHAR_BITS); // a|a b|
+    owriter.put( 2 , 2        );
+    owriter.put('b', CHAR_BITS); // a|a b|a b b|
+    owriter.put( 1 , 2        );
+    owriter.put('c', CHAR_BITS); // a|a b|* * *|a c|
+    owriter.put( 2 , 2        );
+    owriter.put('c', CHAR_BITS); // a|a b|* * *|* *|a b c|a
+    owriter.put( 1 , 2        ); // a|a b|* * *|* *|a b c|a
+    owriter.flush();
+
+    ASSERT_EQ(output, lz78.encode(input));
+    ASSERT_EQ(input, lz78.decode(output));
+}
@@ -1,7 +1,11 @@
 #include "prefix.h"
 
+#include "../src/hash_dict.h"
 #include "../src/lzw.h"
+#include "../src/mra_dict.h"
 #include "../src/smru_dict.h"
+#include "../src/stream_encoder.h"
+#include "../src/wmru_dict.h"
 
 class SmruLzwTest : public testing::Test {
 protected:
@@ -22,6 +26,7 @@ SmruLzwTest::SmruLzwTest () :
     iwriter.put("aababbacabac");
 
     BufferBitWriter owriter(output);
+    owriter.put64(12); // Input length.
     owriter.put(1 + 'a', cwbits);
     // (a  a)
     // 1: a*
@@ -58,3 +63,101 @@ TEST_F (SmruLzwTest, Encoding) {
 TEST_F (SmruLzwTest, Decoding) {
     ASSERT_EQ(input, lzw.decode(output));
 }
+
+TEST_F (SmruLzwTest, CodewordCount) {
+    ASSERT_EQ(9, lzw.min_codeword_cnt(output));
+}
+
+template <typename Dict>
+class LzwResetTest : public testing::Test {
+protected:
+    Buffer input;
+
+    LzwResetTest ();
+
+    // Returns the number of clear codes in `output`, which has been encoded
+    // with fixed width codeword numbers by `lzw`.
+    int64_t clear_cnt (Lzw<Dict> const& lzw, Buffer const& output);
+};
+
+template <typename Dict>
+LzwResetTest<Dict>::LzwResetTest () {
+    // Repetitive words followed by random text over another alphabet, which
+    // compresses much worse.
+    BufferCharWriter writer(input);
+    uint32_t state = 1;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 1103515245 + 12345;
+        int const length = 1 + (state >> 16) % 3;
+        for (int j = 0; j < length; ++j)
+            writer.put(char('a' + (state >> (j + 8)) % 3));
+        writer.put(' ');
+    }
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 1103515245 + 12345;
+        writer.put(char('M' + (state >> 16) % 16));
+    }
+}
+
+template <typename Dict>
+int64_t LzwResetTest<Dict>::clear_cnt (
+    Lzw<Dict> const& lzw,
+    Buffer const& output
+) {
+    BufferBitReader reader(output);
+    reader.get64();
+    int64_t result = 0;
+    while (!reader.eob())
+        result += reader.get(lzw.codeword_bits()) == 0;
+    return result;
+}
+
+typedef testing::Types<Smru, Smru2, FlatSmru, Wmru, Mra, HashWmru> dicts;
+TYPED_TEST_CASE(LzwResetTest, dicts);
+
+TYPED_TEST (LzwResetTest, EncodeDecode) {
+    Lzw<TypeParam> plain(1000);
+    Lzw<TypeParam> lzw(1000, false, true);
+    Buffer const output = lzw.encode(this->input);
+    ASSERT_EQ(0, this->clear_cnt(plain, plain.encode(this->input)));
+    ASSERT_LT(0, this->clear_cnt(lzw, output));
+    ASSERT_EQ(this->input, lzw.decode(output));
+
+    // Other decoders.
+    int64_t const char_cnt = this->input.size() / CHAR_BITS;
+    Buffer input;
+    BufferDecodeSink sink(input);
+    lzw.decode(output, sink);
+    ASSERT_EQ(this->input, input);
+    input.clear();
+    lzw.decode(output, BufferCharWriter(input).append(char_cnt), char_cnt);
+    ASSERT_EQ(this->input, input);
+}
+
+TYPED_TEST (LzwResetTest, VariableWidth) {
+    Lzw<TypeParam> lzw(1000, true, true);
+    ASSERT_EQ(this->input, lzw.decode(lzw.encode(this->input)));
+}
+
+TYPED_TEST (LzwResetTest, Stream) {
+    Lzw<TypeParam> lzw(1000, false, true);
+    int64_t const char_cnt = this->input.size() / CHAR_BITS;
+    StreamEncoder<Lzw<TypeParam>> encoder(lzw);
+    Buffer streamed;
+    encoder.begin(streamed);
+    for (int64_t begin = 0; begin < char_cnt; begin += 1000) {
+        int64_t const length = min(int64_t(1000), char_cnt - begin);
+        encoder.feed(
+            BufferView(this->input).slice_chars(begin, length),
+            streamed
+        );
+    }
+    encoder.finish(streamed);
+    // Only the header differs from the one shot encoding.
+    Buffer const output = lzw.encode(this->input);
+    ASSERT_EQ(
+        BufferView(output).slice(64, output.size() - 64),
+        BufferView(streamed).slice(64, streamed.size() - 64)
+    );
+    ASSERT_EQ(this->input, lzw.decode(streamed));
+}
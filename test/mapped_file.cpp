@@ -0,0 +1,85 @@
+#include "prefix.h"
+#include <fstream>
+
+#include "../src/huffman.h"
+#include "../src/lz78.h"
+#include "../src/mapped_file.h"
+#include "../src/smru_dict.h"
+
+class MappedFileTest : public testing::Test {
+protected:
+    string path;
+
+    MappedFileTest ();
+
+    ~MappedFileTest ();
+
+    // Writes `char_cnt` pseudo random letters to the file at `path` and
+    // returns the same contents in a buffer.
+    Buffer write_file (int64_t char_cnt);
+};
+
+MappedFileTest::MappedFileTest () :
+    path(testing::TempDir() + "lzc_mapped_file_test")
+{
+    /* Do nothing. */
+}
+
+MappedFileTest::~MappedFileTest () {
+    std::remove(path.c_str());
+}
+
+Buffer MappedFileTest::write_file (int64_t char_cnt) {
+    Buffer buffer;
+    BufferCharWriter writer(buffer);
+    std::ofstream file(path.c_str());
+    uint32_t x = 12345;
+    for (int64_t i = 0; i < char_cnt; ++i) {
+        x = x * 1103515245 + 12345;
+        char a = 'a' + (x >> 16) % 4;
+        file.put(a);
+        writer.put(a);
+    }
+    return buffer;
+}
+
+TEST_F (MappedFileTest, Contents) {
+    Buffer expected = write_file(1000);
+    MappedFile file(path);
+    ASSERT_TRUE(file.is_open());
+    ASSERT_TRUE(file.buffer().is_borrowed());
+    ASSERT_EQ(expected, file.buffer());
+
+    BufferCharReader expected_reader(expected);
+    BufferCharReader reader(file.buffer());
+    while (!expected_reader.eob())
+        ASSERT_EQ(expected_reader.get(), reader.get());
+    ASSERT_TRUE(reader.eob());
+}
+
+TEST_F (MappedFileTest, Empty) {
+    write_file(0);
+    MappedFile file(path);
+    ASSERT_TRUE(file.is_open());
+    ASSERT_EQ(0, file.buffer().size());
+    ASSERT_TRUE(BufferCharReader(file.buffer()).eob());
+}
+
+TEST_F (MappedFileTest, Missing) {
+    MappedFile file(path + "_missing");
+    ASSERT_FALSE(file.is_open());
+}
+
+TEST_F (MappedFileTest, PageSizedEncoding) {
+    // The mapping ends exactly at a page boundary, so nothing past the end of
+    // the file may be touched.
+    Buffer expected = write_file(4096);
+    MappedFile file(path);
+    ASSERT_TRUE(file.is_open());
+
+    Lz78<Smru> lz78(100);
+    Buffer output = lz78.encode(file.buffer());
+    ASSERT_EQ(output, lz78.encode(expected));
+    ASSERT_EQ(expected, lz78.decode(output));
+    ASSERT_EQ(file.buffer(), Huffman::decode(Huffman::encode(file.buffer())));
+}
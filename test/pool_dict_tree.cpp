@@ -116,3 +116,87 @@ TEST (PoolDictTreeTest, Extending) {
     ASSERT_EQ(Tag(true, 1, 3, 3), abc->tag);
     ASSERT_EQ(Tag(true, 2, 3, 4), abcd->tag);
 }
+
+TEST (PoolDictTreeTest, CopyAndDetach) {
+    Buffer input;
+    BufferCharWriter(input).put("ab abcd abde");
+
+    PoolDictTree t(input);
+    t.extend(0, -int('a') - 1, 1);
+    t.extend(1, 0, 2);
+    t.extend(2, 3, 3);
+    t.extend(3, 3, 4);
+    // (0)-a-(1)-b-(2)-c-(3)-d-(4)
+
+    PoolDictTree copy(t);
+    copy.detach();
+    // Neither the original nor the input are referred to anymore.
+    input.clear();
+    BufferCharWriter(input).put("xxxxxxxxxxxx");
+    t.extend(2, 8, 5);
+
+    Edge _a = copy.edge(copy.root(), 'a');
+    ASSERT_EQ("a", _a);
+    Edge a_b = copy.edge(_a.dst, 'b');
+    ASSERT_EQ("b", a_b);
+    Edge ab_c = copy.edge(a_b.dst, 'c');
+    ASSERT_EQ("c", ab_c);
+    Edge abc_d = copy.edge(ab_c.dst, 'd');
+    ASSERT_EQ("d", abc_d);
+    ASSERT_TRUE(abc_d.dst->is_leaf());
+    ASSERT_EQ(4, abc_d.dst->tag.codeword_no);
+    ASSERT_LT(abc_d.dst->tag.begin, 0);
+
+    // New codewords go on referring to the attached input.
+    Buffer other;
+    BufferCharWriter(other).put("abcde");
+    copy.attach(other);
+    copy.extend(4, 0, 5);
+    Edge abcd_e = copy.edge(abc_d.dst, 'e');
+    ASSERT_EQ("e", abcd_e);
+    ASSERT_EQ(Tag(true, 5, 0, 5), abcd_e.dst->tag);
+}
+
+TEST (PoolDictTreeTest, Clear) {
+    Buffer input;
+    BufferCharWriter(input).put("abcabcabcabc");
+
+    // Enough nodes to take a few slabs, some of them removed and recycled.
+    PoolDictTree t(input);
+    Node const* const root = t.root();
+    for (int a = 0; a < CHAR_CNT; ++a)
+        t.extend(0, -a - 1, a + 1);
+    for (int j = CHAR_CNT + 1; j <= CHAR_CNT + 4; ++j)
+        t.extend(j == CHAR_CNT + 1 ? int('a') + 1 : j - 1, 0, j);
+    // (0)-a-(98)-b-(257)-c-(258)-a-(259)-b-(260)
+    // Codeword 260 moves back and forth between "bc" and "ca", so that its
+    // nodes are removed and recycled.
+    for (int k = 0; k < 100; ++k) {
+        if (k % 2 == 0)
+            t.extend(int('b') + 1, 1, CHAR_CNT + 4);
+        else
+            t.extend(int('c') + 1, 2, CHAR_CNT + 4);
+    }
+    // (0)-a-(98)-b-(257)-c-(258)-a-(259)
+    //  |
+    //  c-(100)-a-(260)
+    Edge _c = t.edge(root, 'c');
+    ASSERT_EQ("c", _c);
+    ASSERT_EQ(Tag(true, CHAR_CNT + 4, 2, 2), t.edge(_c.dst, 'a').dst->tag);
+    ASSERT_TRUE(t.edge(root, 'b').dst->is_leaf());
+
+    t.clear();
+    ASSERT_EQ(root, t.root());
+    ASSERT_TRUE(root->is_leaf());
+    ASSERT_EQ(Tag(true, 0, 0, 0), root->tag);
+
+    t.extend(0, -int('c') - 1, 1);
+    t.extend(1, 2, 2);
+    // (0)-c-(1)-a-(2)
+    _c = t.edge(root, 'c');
+    ASSERT_EQ("c", _c);
+    ASSERT_EQ(Tag(true, 1, -int('c') - 1, 1), _c.dst->tag);
+    Edge c_a = t.edge(_c.dst, 'a');
+    ASSERT_EQ("a", c_a);
+    ASSERT_EQ(Tag(true, 2, 2, 2), c_a.dst->tag);
+}
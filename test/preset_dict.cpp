@@ -0,0 +1,129 @@
+#include "prefix.h"
+
+#include "../src/buffer.h"
+#include "../src/hash_dict.h"
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+#include "../src/mra_dict.h"
+#include "../src/preset_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/wmru_dict.h"
+
+template <typename Lz>
+class PresetDictTest : public testing::Test {
+protected:
+    Buffer sample;
+    std::vector<Buffer> records;
+
+    PresetDictTest ();
+};
+
+template <typename Lz>
+PresetDictTest<Lz>::PresetDictTest () {
+    // Log-like records sharing most of their text.
+    char const* const levels[] = {"info", "warning", "error"};
+    BufferCharWriter writer(sample);
+    uint32_t state = 1;
+    for (int i = 0; i < 300; ++i) {
+        state = state * 1103515245 + 12345;
+        string const record =
+            "{\"level\": \"" + string(levels[(state >> 16) % 3]) +
+            "\", \"request\": " + std::to_string((state >> 8) % 1000) +
+            ", \"message\": \"connection closed by peer\"}\n";
+        if (i < 200) {
+            writer.put(record);
+        } else {
+            records.emplace_back();
+            BufferCharWriter(records.back()).put(record);
+        }
+    }
+}
+
+typedef testing::Types<
+    Lz78<Smru>,
+    Lzw<Smru>,
+    Lz78<Mra>,
+    Lzw<Mra>,
+    Lz78<Wmru>,
+    Lzw<Wmru>,
+    Lz78<Smru2>,
+    Lzw<Smru2>,
+    Lzw<FlatSmru>,
+    Lz78<HashMra>,
+    Lzw<HashWmru>
+> algos;
+TYPED_TEST_CASE(PresetDictTest, algos);
+
+TYPED_TEST (PresetDictTest, EncodeDecode) {
+    for (int limit : {10, 100, 5000}) {
+        TypeParam lz(limit);
+        PresetDict<TypeParam> preset(lz, this->sample);
+        Buffer output;
+        Buffer input;
+        for (Buffer const& record : this->records) {
+            preset.encode(record, output);
+            preset.decode(output, input);
+            ASSERT_EQ(record, input);
+        }
+    }
+}
+
+TYPED_TEST (PresetDictTest, Smaller) {
+    TypeParam lz(5000);
+    PresetDict<TypeParam> preset(lz, this->sample);
+    int64_t plain_bits = 0;
+    int64_t preset_bits = 0;
+    Buffer output;
+    for (Buffer const& record : this->records) {
+        plain_bits += lz.encode(record).size();
+        preset.encode(record, output);
+        preset_bits += output.size();
+    }
+    ASSERT_LT(2 * preset_bits, plain_bits);
+}
+
+TYPED_TEST (PresetDictTest, Unchanged) {
+    // Every call starts from the same trained state.
+    TypeParam lz(100);
+    PresetDict<TypeParam> preset(lz, this->sample);
+    Buffer first;
+    Buffer output;
+    preset.encode(this->records[0], first);
+    for (Buffer const& record : this->records)
+        preset.encode(record, output);
+    preset.encode(this->records[0], output);
+    ASSERT_EQ(first, output);
+}
+
+TYPED_TEST (PresetDictTest, SaveLoad) {
+    TypeParam lz(100, true);
+    PresetDict<TypeParam> preset(lz, this->sample);
+    Buffer saved;
+    preset.save(saved);
+    ASSERT_LT(saved.size(), this->sample.size());
+    PresetDict<TypeParam> loaded(lz, lz.decode(saved));
+    Buffer output;
+    Buffer loaded_output;
+    Buffer input;
+    for (Buffer const& record : this->records) {
+        preset.encode(record, output);
+        loaded.encode(record, loaded_output);
+        ASSERT_EQ(output, loaded_output);
+        loaded.decode(output, input);
+        ASSERT_EQ(record, input);
+    }
+}
+
+TYPED_TEST (PresetDictTest, EmptySample) {
+    TypeParam lz(100);
+    PresetDict<TypeParam> preset(lz, Buffer());
+    Buffer output;
+    Buffer input;
+    preset.encode(this->records[0], output);
+    ASSERT_EQ(lz.encode(this->records[0]), output);
+    preset.decode(output, input);
+    ASSERT_EQ(this->records[0], input);
+    preset.encode(Buffer(), output);
+    preset.decode(output, input);
+    ASSERT_EQ(Buffer(), input);
+}
@@ -1,5 +1,7 @@
 #include "prefix.h"
+#include <vector>
 
+#include "../src/index_queue.h"
 #include "../src/smru_dict.cpp"
 
 TEST (SmruDictTest, Encoding) {
@@ -197,3 +199,74 @@ TEST (SmruDictTest, DecodingWithSingleCharCodewords) {
     ASSERT_EQ(Codeword(2, 2), d.codeword(CHAR_CNT + 2));
     ASSERT_EQ(Codeword(4, 3), d.codeword(CHAR_CNT + 3));
 }
+
+// The SMRU policy done the obvious way, moving all prefixes of the matched
+// codeword to the back of the discard queue.
+class QueueSmruPool {
+public:
+    QueueSmruPool (int limit, int fixed_cnt) :
+        m_limit(limit),
+        m_fixed_cnt(fixed_cnt),
+        m_queue(limit),
+        m_parents(limit + 1, 0),
+        m_size(fixed_cnt)
+    {
+        /* Do nothing. */
+    }
+
+    int size () const {
+        return m_size;
+    }
+
+    int match (int i) {
+        for (int j = i; j > m_fixed_cnt; j = m_parents[j])
+            m_queue.move_to_back(j);
+        int j = m_size < m_limit ? ++m_size : m_queue.front();
+        if (j == i)
+            return 0;
+        if (m_queue.contains(j))
+            m_queue.erase(j);
+        if (i <= m_fixed_cnt)
+            m_queue.push_back(j);
+        else
+            m_queue.insert(i, j);
+        m_parents[j] = i;
+        return j;
+    }
+
+private:
+    int m_limit;
+    int m_fixed_cnt;
+    IndexQueue m_queue;
+    std::vector<int> m_parents;
+    int m_size;
+};
+
+TEST (SmruDictTest, SameAsQueue) {
+    for (bool single_char_codewords : {false, true}) {
+        int const fixed_cnt = single_char_codewords ? CHAR_CNT : 0;
+        for (int limit : {1, 2, 3, 10, 100, 1000}) {
+            if (single_char_codewords)
+                limit += CHAR_CNT;
+            SmruPool pool(limit, single_char_codewords);
+            QueueSmruPool queue(limit, fixed_cnt);
+            uint32_t state = 5;
+            int last = 0;
+            for (int k = 0; k < 20000; ++k) {
+                if (k == 10000) {
+                    pool.reset();
+                    queue = QueueSmruPool(limit, fixed_cnt);
+                    last = 0;
+                }
+                state = state * 1103515245 + 12345;
+                // Extending the last codeword in turns makes long chains of
+                // prefixes, like repetitive input does.
+                int const i = (state >> 24) % 3 == 0
+                    ? (state >> 4) % (queue.size() + 1)
+                    : last;
+                last = queue.match(i);
+                ASSERT_EQ(last, pool.match(i));
+            }
+        }
+    }
+}
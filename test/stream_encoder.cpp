@@ -0,0 +1,147 @@
+#include "prefix.h"
+
+#include "../src/buffer.h"
+#include "../src/hash_dict.h"
+#include "../src/lz78.h"
+#include "../src/lzw.h"
+#include "../src/mra_dict.h"
+#include "../src/smru_dict.h"
+#include "../src/stream_encoder.h"
+#include "../src/wmru_dict.h"
+
+template <typename Lz>
+class StreamEncoderTest : public testing::Test {
+protected:
+    Buffer lorem_ipsum;
+    Buffer words;
+
+    StreamEncoderTest ();
+
+    // Encodes `input` fed in chunks of `chunk_cnt` chars.
+    Buffer stream_encode (Lz const& lz, Buffer const& input, int64_t chunk_cnt);
+
+    // Checks that the streamed encoding differs from the one shot encoding
+    // only in the header.
+    void check (Lz const& lz, Buffer const& input, Buffer const& streamed);
+};
+
+template <typename Lz>
+StreamEncoderTest<Lz>::StreamEncoderTest () {
+    BufferCharWriter(lorem_ipsum).put(
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Donec "
+        "interdum cursus venenatis. Proin eget fringilla nulla, ut sagittis "
+        "sem. Pellentesque habitant morbi tristique senectus et netus et "
+        "malesuada fames ac turpis egestas. Nunc ultrices erat sit amet leo "
+        "accumsan congue. Duis faucibus justo felis, vel pulvinar enim tempus "
+        "condimentum."
+    );
+
+    // Pseudo-random words, long enough to have the window compacted a few
+    // times.
+    BufferCharWriter writer(words);
+    uint32_t state = 1;
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 1103515245 + 12345;
+        int const length = 1 + (state >> 16) % 7;
+        for (int j = 0; j < length; ++j)
+            writer.put(char('a' + (state >> (j + 8)) % 6));
+        writer.put(' ');
+    }
+}
+
+template <typename Lz>
+Buffer StreamEncoderTest<Lz>::stream_encode (
+    Lz const& lz,
+    Buffer const& input,
+    int64_t chunk_cnt
+) {
+    int64_t const char_cnt = input.size() / CHAR_BITS;
+    StreamEncoder<Lz> encoder(lz);
+    Buffer output;
+    encoder.begin(output);
+    for (int64_t begin = 0; begin < char_cnt; begin += chunk_cnt) {
+        int64_t const length = min(chunk_cnt, char_cnt - begin);
+        encoder.feed(BufferView(input).slice_chars(begin, length), output);
+        EXPECT_EQ(0, output.size() % WORD_BITS);
+    }
+    encoder.finish(output);
+    return output;
+}
+
+template <typename Lz>
+void StreamEncoderTest<Lz>::check (
+    Lz const& lz,
+    Buffer const& input,
+    Buffer const& streamed
+) {
+    Buffer const oneshot = lz.encode(input);
+    BufferView const body(oneshot);
+    ASSERT_EQ(oneshot.size(), streamed.size());
+    ASSERT_EQ(0u, BufferBitReader(streamed).get64());
+    ASSERT_EQ(
+        body.slice(64, body.size() - 64),
+        BufferView(streamed).slice(64, body.size() - 64)
+    );
+    ASSERT_EQ(input, lz.decode(streamed));
+}
+
+typedef testing::Types<
+    Lz78<Smru>,
+    Lzw<Smru>,
+    Lz78<Mra>,
+    Lzw<Mra>,
+    Lz78<Wmru>,
+    Lzw<Wmru>,
+    Lz78<Smru2>,
+    Lzw<Smru2>,
+    Lz78<FlatSmru>,
+    Lz78<HashMra>,
+    Lzw<HashWmru>
+> algos;
+TYPED_TEST_CASE(StreamEncoderTest, algos);
+
+TYPED_TEST (StreamEncoderTest, Chunks) {
+    TypeParam lz(10);
+    int64_t const char_cnt = this->lorem_ipsum.size() / CHAR_BITS;
+    for (int64_t chunk_cnt : {int64_t(1), int64_t(7), int64_t(64), char_cnt}) {
+        Buffer streamed = this->stream_encode(lz, this->lorem_ipsum, chunk_cnt);
+        this->check(lz, this->lorem_ipsum, streamed);
+    }
+}
+
+TYPED_TEST (StreamEncoderTest, VariableWidth) {
+    TypeParam lz(10, true);
+    Buffer streamed = this->stream_encode(lz, this->lorem_ipsum, 7);
+    this->check(lz, this->lorem_ipsum, streamed);
+}
+
+TYPED_TEST (StreamEncoderTest, Empty) {
+    TypeParam lz(10);
+    StreamEncoder<TypeParam> encoder(lz);
+    Buffer output;
+    encoder.begin(output);
+    encoder.feed(BufferView(), output);
+    encoder.finish(output);
+    ASSERT_EQ(Buffer(), lz.decode(output));
+}
+
+TYPED_TEST (StreamEncoderTest, BoundedWindow) {
+    TypeParam lz(500);
+    int64_t const char_cnt = this->words.size() / CHAR_BITS;
+    int64_t const chunk_cnt = 4096;
+    StreamEncoder<TypeParam> encoder(lz);
+    Buffer streamed;
+    int64_t max_retained = 0;
+    encoder.begin(streamed);
+    for (int64_t begin = 0; begin < char_cnt; begin += chunk_cnt) {
+        int64_t const length = min(chunk_cnt, char_cnt - begin);
+        BufferView const chunk = BufferView(this->words).slice_chars(
+            begin, length
+        );
+        encoder.feed(chunk, streamed);
+        max_retained = max(max_retained, encoder.retained());
+    }
+    encoder.finish(streamed);
+    ASSERT_LT(max_retained, char_cnt / 2);
+    this->check(lz, this->words, streamed);
+}
@@ -0,0 +1,27 @@
+#include "prefix.h"
+#include <vector>
+
+#include "../src/thread_pool.h"
+
+TEST (ThreadPoolTest, EveryTaskOnce) {
+    for (int worker_cnt : {0, 1, 3}) {
+        ThreadPool pool(worker_cnt);
+        ASSERT_EQ(worker_cnt + 1, pool.thread_cnt());
+        for (int64_t task_cnt : {0, 1, 2, 100, 1000}) {
+            std::vector<std::atomic<int>> calls(task_cnt);
+            for (std::atomic<int>& call_cnt : calls)
+                call_cnt = 0;
+            pool.run(task_cnt, [&calls] (int64_t i) { ++calls[i]; });
+            for (std::atomic<int>& call_cnt : calls)
+                ASSERT_EQ(1, call_cnt);
+        }
+    }
+}
+
+TEST (ThreadPoolTest, ManyRuns) {
+    ThreadPool pool(2);
+    std::atomic<int64_t> sum(0);
+    for (int run = 0; run < 1000; ++run)
+        pool.run(3, [&sum] (int64_t i) { sum += i; });
+    ASSERT_EQ(3000, sum);
+}
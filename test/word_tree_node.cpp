@@ -1,4 +1,5 @@
 #include "prefix.h"
+#include <vector>
 
 #include "../src/word_tree_node.h"
 
@@ -34,3 +35,46 @@ TEST (WordTreeNodeTest, Linking) {
     EXPECT_EQ(&node1, root.child('a'));
     EXPECT_EQ(&node2, node1.child('c'));
 }
+
+TEST (WordTreeNodeTest, ManyChildren) {
+    WordTreeNode<int> root(0);
+    std::vector<WordTreeNode<int>*> nodes;
+    for (int a = 0; a < CHAR_CNT; ++a)
+        nodes.push_back(new WordTreeNode<int>(a));
+
+    // The children are linked in a scattered order, so that they pass through
+    // every representation and are inserted in the middle.
+    for (int k = 0; k < CHAR_CNT; ++k) {
+        int const a = k * 37 % CHAR_CNT;
+        root.link_child(a, nodes[a]);
+        ASSERT_EQ(k + 1, root.child_cnt());
+        ASSERT_EQ(nodes[a], root.child(a));
+        if (k + 1 < CHAR_CNT) {
+            ASSERT_EQ(nullptr, root.child((k + 1) * 37 % CHAR_CNT));
+        }
+    }
+
+    // They are unlinked, again scattered, all the way back.
+    for (int k = 0; k < CHAR_CNT; ++k) {
+        int const a = k * 101 % CHAR_CNT;
+        nodes[a]->unlink();
+        ASSERT_EQ(CHAR_CNT - k - 1, root.child_cnt());
+        ASSERT_EQ(nullptr, root.child(a));
+        // The rest are visited in the order of their labels.
+        int prev = -1;
+        int cnt = 0;
+        for (auto kv : root) {
+            int const b = uint8_t(kv.first);
+            ASSERT_LT(prev, b);
+            ASSERT_EQ(nodes[b], kv.second);
+            ASSERT_EQ(nodes[b], root.child(kv.first));
+            prev = b;
+            ++cnt;
+        }
+        ASSERT_EQ(root.child_cnt(), cnt);
+    }
+    ASSERT_TRUE(root.is_leaf());
+
+    for (WordTreeNode<int>* node : nodes)
+        delete node;
+}